@@ -1,33 +1,280 @@
 // Conteúdo Chave de libtslog/tslog.cpp
 #include "tslog.h"
-// ... (outros includes)
+#include <cstdio>  // rename, remove
+#include <cstdlib> // atexit
+#include <sys/stat.h>
 
 ThreadSafeLogger* ThreadSafeLogger::instance = nullptr;
+std::mutex ThreadSafeLogger::format_mutex;
+std::vector<std::string> ThreadSafeLogger::formats;
+
+#define TSLOG_BINARY_VERSION 1
+#define TSLOG_RECORD_FORMAT 1
+#define TSLOG_RECORD_LOG 2
+// No máximo esta janela de registros fica só no buffer (WARNING/ERROR vão na hora)
+#define TSLOG_FLUSH_INTERVAL_MS 1000
+
+static void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static uint64_t toMicros(std::chrono::system_clock::time_point t) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count());
+}
+
+// Ids pequenos e estáveis por thread (o std::thread::id é grande e opaco)
+static uint32_t currentThreadId() {
+    static std::atomic<uint32_t> next_id(1);
+    thread_local uint32_t id = next_id++;
+    return id;
+}
+
+ThreadSafeLogger* ThreadSafeLogger::create() {
+    instance = new ThreadSafeLogger();
+    // O singleton nunca é destruído: o que estiver no buffer vai para o disco na saída
+    std::atexit([] { instance->flush(); });
+    return instance;
+}
+
+const char* ThreadSafeLogger::levelName(LogLevel level) {
+    switch (level) {
+        case DEBUG: return "DEBUG";
+        case INFO: return "INFO";
+        case WARNING: return "WARN";
+        case ERROR: return "ERROR";
+    }
+    return "?";
+}
+
+uint32_t ThreadSafeLogger::internFormat(const char* fmt) {
+    std::lock_guard<std::mutex> lock(format_mutex);
+    formats.push_back(fmt);
+    return static_cast<uint32_t>(formats.size());
+}
+
+std::string ThreadSafeLogger::getFormat(uint32_t fmt_id) {
+    std::lock_guard<std::mutex> lock(format_mutex);
+    if (fmt_id == 0 || fmt_id > formats.size()) return "{}";
+    return formats[fmt_id - 1];
+}
+
+// Abre o arquivo configurado; chamado com log_mutex travado
+void ThreadSafeLogger::openFile(bool rotate_existing) {
+    if (config_.format == LogFormat::BINARY) {
+        // Um arquivo binário sempre começa do zero: o anterior vai para a rotação
+        struct stat st;
+        if (rotate_existing && stat(config_.filename.c_str(), &st) == 0 && st.st_size > 0) {
+            rotate();
+            return;
+        }
+        log_file.open(config_.filename, std::ios::binary | std::ios::trunc);
+        file_records_ = 0;
+        file_opened_ = std::chrono::system_clock::now();
+        last_us_ = toMicros(file_opened_);
+        std::string header = "TSLOGB";
+        header.push_back(static_cast<char>(TSLOG_BINARY_VERSION));
+        appendVarint(header, last_us_);
+        log_file.write(header.data(), header.size());
+        file_bytes_ = header.size();
+        defined_in_file_.assign(defined_in_file_.size(), false);
+    } else {
+        log_file.open(config_.filename, std::ios_base::app); // Abre em modo append
+        struct stat st;
+        file_bytes_ = stat(config_.filename.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+        file_records_ = file_bytes_ > 0 ? 1 : 0;
+        file_opened_ = std::chrono::system_clock::now();
+    }
+}
+
+// arquivo -> arquivo.1 -> ... -> arquivo.N (o mais antigo é apagado)
+void ThreadSafeLogger::rotate() {
+    if (log_file.is_open()) {
+        log_file.close();
+    }
+    const std::string& base = config_.filename;
+    if (config_.retention <= 0) {
+        std::remove(base.c_str());
+    } else {
+        std::remove((base + "." + std::to_string(config_.retention)).c_str());
+        for (int i = config_.retention - 1; i >= 1; --i) {
+            std::rename((base + "." + std::to_string(i)).c_str(),
+                        (base + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(base.c_str(), (base + ".1").c_str());
+    }
+    openFile(false);
+}
+
+void ThreadSafeLogger::configure(const LoggerConfig& config) {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    if (log_file.is_open()) {
+        log_file.close();
+    }
+    config_ = config;
+    min_level_ = config.min_level;
+    binary_ = config.format == LogFormat::BINARY;
+    console_ = config.console;
+    file_ready_ = false;
+}
+
+void ThreadSafeLogger::flusherLoop() {
+    std::unique_lock<std::mutex> lock(log_mutex);
+    while (!stopping_) {
+        flusher_cv_.wait_for(lock, std::chrono::milliseconds(TSLOG_FLUSH_INTERVAL_MS));
+        // A rotação por tempo também acontece com o servidor ocioso
+        if (file_ready_ && file_records_ > 0 && config_.max_file_age_s > 0 &&
+            std::chrono::system_clock::now() - file_opened_ >= std::chrono::seconds(config_.max_file_age_s)) {
+            rotate();
+        }
+        log_file.flush();
+    }
+}
+
+void ThreadSafeLogger::flush() {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    log_file.flush();
+}
+
+size_t ThreadSafeLogger::getMemoryUsage() {
+    size_t total = sizeof(ThreadSafeLogger);
+    {
+        std::lock_guard<std::mutex> lock(log_mutex);
+        total += config_.filename.capacity() + cached_time_.capacity() + defined_in_file_.capacity() / 8;
+        total += BUFSIZ; // buffer do filebuf
+    }
+    std::lock_guard<std::mutex> lock(format_mutex);
+    total += formats.capacity() * sizeof(std::string);
+    for (const std::string& fmt : formats) {
+        total += fmt.capacity();
+    }
+    return total;
+}
+
+// ctime() só uma vez por segundo; as outras linhas do mesmo segundo reutilizam o texto
+const std::string& ThreadSafeLogger::timeText(std::chrono::system_clock::time_point now) {
+    time_t second = std::chrono::system_clock::to_time_t(now);
+    if (second != cached_second_ || cached_time_.empty()) {
+        cached_time_ = std::ctime(&second);
+        cached_time_.pop_back(); // Remove o '\n'
+        cached_second_ = second;
+    }
+    return cached_time_;
+}
+
+std::string ThreadSafeLogger::render(uint32_t fmt_id, const LogArg* args, size_t argc) {
+    if (fmt_id == 0) {
+        return argc > 0 ? args[0].str_value : std::string();
+    }
+    std::string fmt = getFormat(fmt_id);
+    std::string out;
+    size_t next = 0, pos = 0;
+    while (true) {
+        size_t mark = fmt.find("{}", pos);
+        if (mark == std::string::npos || next >= argc) break;
+        out.append(fmt, pos, mark - pos);
+        const LogArg& a = args[next++];
+        out += a.is_int ? std::to_string(a.int_value) : a.str_value;
+        pos = mark + 2;
+    }
+    out.append(fmt, pos, std::string::npos);
+    return out;
+}
 
 void ThreadSafeLogger::log(LogLevel level, const std::string& message) {
+    LogArg arg;
+    arg.str_value = message;
+    writeRecord(level, 0, &arg, 1);
+}
+
+void ThreadSafeLogger::writeRecord(LogLevel level, uint32_t fmt_id, const LogArg* args, size_t argc) {
+    uint32_t thread_id = currentThreadId();
+    bool binary = binary_.load(std::memory_order_relaxed);
+    bool console = console_.load(std::memory_order_relaxed);
+
+    // Formatação fora do lock: texto só quando alguém vai ler texto
+    std::string message;
+    if (!binary || console) {
+        message = render(fmt_id, args, argc);
+    }
+    std::string body;
+    if (binary) {
+        body.push_back(static_cast<char>(level));
+        appendVarint(body, thread_id);
+        appendVarint(body, fmt_id);
+        appendVarint(body, argc);
+        for (size_t i = 0; i < argc; ++i) {
+            if (args[i].is_int) {
+                body.push_back(1);
+                int64_t v = args[i].int_value;
+                appendVarint(body, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); // zigzag
+            } else {
+                body.push_back(0);
+                appendVarint(body, args[i].str_value.size());
+                body += args[i].str_value;
+            }
+        }
+    }
+
     // 1. Bloqueia o mutex
     std::lock_guard<std::mutex> lock(log_mutex); // RAII para proteção contra exceções
-    
+
     // 2. Formata a mensagem com timestamp e nível
-    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    std::string time_str = std::ctime(&now);
-    time_str.pop_back(); // Remove o '\n'
+    auto now = std::chrono::system_clock::now();
+    if (!file_ready_) {
+        openFile();
+        file_ready_ = true;
+    }
+    std::string final_message;
+    if (!binary || console) {
+        final_message = "[" + timeText(now) + "] [" + levelName(level) + "] " + message;
+    }
 
-    std::string level_str;
-    switch (level) {
-        case DEBUG: level_str = "DEBUG"; break;
-        case INFO: level_str = "INFO"; break;
-        case WARNING: level_str = "WARN"; break;
-        case ERROR: level_str = "ERROR"; break;
+    if ((config_.max_file_bytes > 0 && file_bytes_ >= config_.max_file_bytes) ||
+        (config_.max_file_age_s > 0 && now - file_opened_ >= std::chrono::seconds(config_.max_file_age_s))) {
+        rotate();
     }
 
-    std::string final_message = "[" + time_str + "] [" + level_str + "] " + message;
-    
     // 3. Escreve no arquivo e no console (opcional, mas útil)
     if (log_file.is_open()) {
-        log_file << final_message << std::endl;
+        ++file_records_;
+        if (binary && config_.format == LogFormat::BINARY) {
+            std::string out;
+            if (fmt_id != 0) {
+                if (defined_in_file_.size() <= fmt_id) defined_in_file_.resize(fmt_id + 1, false);
+                if (!defined_in_file_[fmt_id]) {
+                    std::string fmt_text = getFormat(fmt_id);
+                    out.push_back(TSLOG_RECORD_FORMAT);
+                    appendVarint(out, fmt_id);
+                    appendVarint(out, fmt_text.size());
+                    out += fmt_text;
+                    defined_in_file_[fmt_id] = true;
+                }
+            }
+            // Threads diferentes podem medir fora de ordem; o delta nunca é negativo
+            uint64_t now_us = toMicros(now);
+            if (now_us < last_us_) now_us = last_us_;
+            out.push_back(TSLOG_RECORD_LOG);
+            appendVarint(out, now_us - last_us_);
+            out += body;
+            last_us_ = now_us;
+            log_file.write(out.data(), out.size());
+            file_bytes_ += out.size();
+        } else if (!binary && config_.format == LogFormat::TEXT) {
+            log_file << final_message << '\n';
+            file_bytes_ += final_message.size() + 1;
+        }
+        if (level >= WARNING) {
+            log_file.flush();
+        }
+    }
+    if (console) {
+        std::cout << final_message << std::endl;
     }
-    std::cout << final_message << std::endl;
 
     // 4. O mutex é liberado automaticamente ao sair do escopo do lock_guard
-}
\ No newline at end of file
+}
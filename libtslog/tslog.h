@@ -2,14 +2,60 @@
 #define TSLOG_H
 
 #include <string>
+#include <atomic>
 #include <fstream>
 #include <mutex>
 #include <iostream>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 // Um enum simples para níveis de log
 enum LogLevel { DEBUG, INFO, WARNING, ERROR };
 
+// TEXT: uma linha legível por registro (formato original).
+// BINARY: registros compactos, lidos depois com o tslog_decode:
+//   cabeçalho "TSLOGB" + versão (1 byte) + início em µs desde a época (varint)
+//   definição de formato: 1 (byte), id (varint), tamanho (varint), texto
+//   registro: 2 (byte), delta de tempo em µs (varint), nível (byte),
+//             thread (varint), formato (varint), nº de argumentos (varint),
+//             argumentos: 0 + tamanho (varint) + bytes | 1 + inteiro zigzag (varint)
+// O formato 0 é o texto livre do TSLOG (um argumento string). Cada arquivo
+// define os formatos que usa, então cada arquivo rotacionado se decodifica sozinho.
+enum class LogFormat { TEXT, BINARY };
+
+struct LoggerConfig {
+    std::string filename = "chat_server.log";
+    LogFormat format = LogFormat::TEXT;
+    LogLevel min_level = DEBUG;
+    size_t max_file_bytes = 0;   // rotaciona ao passar deste tamanho (0 = nunca)
+    int max_file_age_s = 0;      // rotaciona após este tempo (0 = nunca)
+    int retention = 5;           // arquivos antigos mantidos: .1 (mais novo) até .N
+    bool console = true;         // também escreve (em texto) no console
+};
+
+// Argumento de um TSLOGF: inteiros ficam binários, o resto vira texto
+struct LogArg {
+    bool is_int = false;
+    int64_t int_value = 0;
+    std::string str_value;
+};
+
+inline LogArg tslogArg(const std::string& value) { LogArg a; a.str_value = value; return a; }
+inline LogArg tslogArg(const char* value) { LogArg a; a.str_value = value; return a; }
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, LogArg>::type tslogArg(T value) {
+    LogArg a; a.is_int = true; a.int_value = static_cast<int64_t>(value); return a;
+}
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, LogArg>::type tslogArg(T value) {
+    LogArg a; a.str_value = std::to_string(value); return a;
+}
+
 // A classe Logger implementada como um Singleton para fácil acesso em todo o programa.
 class ThreadSafeLogger {
 private:
@@ -17,11 +63,45 @@ private:
     std::mutex log_mutex;
     static ThreadSafeLogger* instance;
 
+    LoggerConfig config_;
+    // Cópias de config_ lidas sem lock (filtro das macros e preparo do registro)
+    std::atomic<int> min_level_{DEBUG};
+    std::atomic<bool> binary_{false};
+    std::atomic<bool> console_{true};
+    bool file_ready_ = false; // aberto no primeiro registro (configure pode trocar o arquivo antes)
+    size_t file_bytes_ = 0;
+    size_t file_records_ = 0; // um arquivo sem registros não é rotacionado por tempo
+    std::chrono::system_clock::time_point file_opened_;
+    uint64_t last_us_ = 0;                  // último tempo gravado (formato binário)
+    std::vector<bool> defined_in_file_;     // formatos já definidos no arquivo atual
+
+    // Cabeçalho de tempo do formato texto: refeito no máximo uma vez por segundo
+    time_t cached_second_ = 0;
+    std::string cached_time_;
+
+    // Formatos registrados pelo TSLOGF (o índice é o id - 1)
+    static std::mutex format_mutex;
+    static std::vector<std::string> formats;
+
+    // Flush periódico (a escrita não força flush a cada linha)
+    std::thread flusher_thread_;
+    std::condition_variable flusher_cv_;
+    bool stopping_ = false;
+
     // Construtor privado para garantir o padrão Singleton
     ThreadSafeLogger(const std::string& filename = "chat_server.log") {
-        log_file.open(filename, std::ios_base::app); // Abre em modo append
+        config_.filename = filename;
+        flusher_thread_ = std::thread(&ThreadSafeLogger::flusherLoop, this);
     }
 
+    static ThreadSafeLogger* create();
+    void openFile(bool rotate_existing = true);
+    void rotate();
+    void flusherLoop();
+    const std::string& timeText(std::chrono::system_clock::time_point now);
+    std::string render(uint32_t fmt_id, const LogArg* args, size_t argc);
+    void writeRecord(LogLevel level, uint32_t fmt_id, const LogArg* args, size_t argc);
+
 public:
     // Evita cópia e movimentação
     ThreadSafeLogger(const ThreadSafeLogger&) = delete;
@@ -29,25 +109,70 @@ public:
 
     // Método de acesso ao Singleton
     static ThreadSafeLogger& getInstance() {
-        if (instance == nullptr) {
-            instance = new ThreadSafeLogger();
-        }
-        return *instance;
+        // Inicialização estática local: segura mesmo com várias threads no primeiro uso
+        static ThreadSafeLogger* created = create();
+        return *created;
     }
-    
+
     // Destrutor para fechar o arquivo
     ~ThreadSafeLogger() {
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            stopping_ = true;
+        }
+        flusher_cv_.notify_all();
+        if (flusher_thread_.joinable()) {
+            flusher_thread_.join();
+        }
         if (log_file.is_open()) {
             log_file.close();
         }
     }
 
+    // Troca arquivo, formato, rotação e console; chamar no início do programa
+    void configure(const LoggerConfig& config);
+
+    bool isEnabled(LogLevel level) const { return level >= min_level_.load(std::memory_order_relaxed); }
+
     // A função principal de logging
     void log(LogLevel level, const std::string& message);
+
+    // Registro com formato fixo ("{}" marca cada argumento); ver TSLOGF
+    template <typename... Args>
+    void logFormat(LogLevel level, uint32_t fmt_id, const Args&... args) {
+        const LogArg list[] = {LogArg(), tslogArg(args)...}; // o primeiro só evita array vazio
+        writeRecord(level, fmt_id, list + 1, sizeof...(Args));
+    }
+
+    void flush();
+
+    // Estimativa dos bytes em heap do logger (formatos registrados e estado do arquivo)
+    size_t getMemoryUsage();
+
+    // Registra um formato e devolve seu id (1, 2, ...)
+    static uint32_t internFormat(const char* fmt);
+    static std::string getFormat(uint32_t fmt_id);
+
+    static const char* levelName(LogLevel level);
 };
 
 // Macro de conveniência para uso mais limpo no código
 #define TSLOG(level, message) \
-    ThreadSafeLogger::getInstance().log(level, message)
+    do { \
+        ThreadSafeLogger& tslog_logger_ = ThreadSafeLogger::getInstance(); \
+        if (tslog_logger_.isEnabled(level)) tslog_logger_.log(level, message); \
+    } while (0)
+
+// Versão para caminhos quentes: o formato (literal) é registrado uma vez por
+// ponto de chamada e no formato binário só os argumentos são gravados.
+//   TSLOGF(DEBUG, "Mensagem recebida de {}: {}", nome, texto);
+#define TSLOGF(level, fmt, ...) \
+    do { \
+        ThreadSafeLogger& tslog_logger_ = ThreadSafeLogger::getInstance(); \
+        if (tslog_logger_.isEnabled(level)) { \
+            static const uint32_t tslog_fmt_id_ = ThreadSafeLogger::internFormat(fmt); \
+            tslog_logger_.logFormat(level, tslog_fmt_id_, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
-#endif // TSLOG_H
\ No newline at end of file
+#endif // TSLOG_H
@@ -0,0 +1,138 @@
+// Arquivo: libtslog/tslog_decode.cpp
+// Converte logs binários (LogFormat::BINARY) em texto, no mesmo formato das
+// linhas do modo texto, com o tempo em µs e a thread de origem.
+//
+// Uso: tslog_decode ARQUIVO... (vários arquivos em ordem: chat_server.log.2 chat_server.log.1 chat_server.log)
+
+#include "tslog.h"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+static bool readVarint(std::istream& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if (c == EOF) return false;
+        value |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+static bool readString(std::istream& in, std::string& out) {
+    uint64_t length = 0;
+    // Um tamanho absurdo indica arquivo corrompido
+    if (!readVarint(in, length) || length > 64 * 1024 * 1024) return false;
+    out.resize(length);
+    return length == 0 || static_cast<bool>(in.read(&out[0], length));
+}
+
+static std::string formatTime(uint64_t us) {
+    time_t second = static_cast<time_t>(us / 1000000);
+    char buf[64];
+    struct tm tm_value;
+    localtime_r(&second, &tm_value);
+    strftime(buf, sizeof(buf), "%a %b %d %H:%M:%S", &tm_value);
+    char frac[16];
+    snprintf(frac, sizeof(frac), ".%06llu", static_cast<unsigned long long>(us % 1000000));
+    char year[8];
+    strftime(year, sizeof(year), " %Y", &tm_value);
+    return std::string(buf) + frac + year;
+}
+
+// Devolve false se o arquivo não for um log binário; uma cauda truncada só encerra a leitura
+static bool decodeFile(const std::string& path, std::ostream& out) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[6];
+    if (!in.read(magic, 6) || std::string(magic, 6) != "TSLOGB" || in.get() != 1) {
+        return false;
+    }
+    uint64_t now_us = 0;
+    if (!readVarint(in, now_us)) return false;
+
+    std::map<uint64_t, std::string> formats;
+    while (true) {
+        int type = in.get();
+        if (type == EOF) break;
+
+        if (type == 1) {
+            uint64_t id = 0;
+            std::string text;
+            if (!readVarint(in, id) || !readString(in, text)) break;
+            formats[id] = text;
+            continue;
+        }
+        if (type != 2) {
+            std::cerr << path << ": registro desconhecido (" << type << "), leitura interrompida" << std::endl;
+            break;
+        }
+
+        uint64_t delta = 0, thread_id = 0, fmt_id = 0, argc = 0;
+        int level = 0;
+        if (!readVarint(in, delta) || (level = in.get()) == EOF || !readVarint(in, thread_id) ||
+            !readVarint(in, fmt_id) || !readVarint(in, argc)) break;
+        now_us += delta;
+
+        std::vector<std::string> args;
+        bool ok = true;
+        for (uint64_t i = 0; i < argc && ok; ++i) {
+            int tag = in.get();
+            std::string value;
+            if (tag == 0) {
+                ok = readString(in, value);
+            } else if (tag == 1) {
+                uint64_t z = 0;
+                ok = readVarint(in, z);
+                int64_t v = static_cast<int64_t>(z >> 1) ^ -static_cast<int64_t>(z & 1);
+                value = std::to_string(v);
+            } else {
+                ok = false;
+            }
+            args.push_back(value);
+        }
+        if (!ok) break;
+
+        std::string message;
+        if (fmt_id == 0) {
+            message = args.empty() ? std::string() : args[0];
+        } else {
+            auto it = formats.find(fmt_id);
+            std::string fmt = it != formats.end() ? it->second : "<formato " + std::to_string(fmt_id) + ">";
+            size_t pos = 0, next = 0;
+            while (true) {
+                size_t mark = fmt.find("{}", pos);
+                if (mark == std::string::npos || next >= args.size()) break;
+                message.append(fmt, pos, mark - pos);
+                message += args[next++];
+                pos = mark + 2;
+            }
+            message.append(fmt, pos, std::string::npos);
+        }
+
+        out << "[" << formatTime(now_us) << "] ["
+            << ThreadSafeLogger::levelName(static_cast<LogLevel>(level)) << "] [T"
+            << thread_id << "] " << message << '\n';
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " ARQUIVO...\n"
+                  << "  decodifica logs binários (chat_server --log-format binary) para texto\n";
+        return 1;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!decodeFile(argv[i], std::cout)) {
+            std::cerr << argv[i] << ": não é um log binário do tslog" << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
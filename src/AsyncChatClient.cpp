@@ -0,0 +1,415 @@
+#include "AsyncChatClient.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define ASYNC_READ_SIZE 16384
+#define ASYNC_MAX_EVENTS 256
+
+AsyncChatClient::AsyncChatClient() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        TSLOG(ERROR, "Falha ao criar epoll/eventfd do cliente assíncrono.");
+        throw std::runtime_error("Falha ao inicializar o cliente assíncrono.");
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0; // id 0 é reservado para o eventfd
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+}
+
+void AsyncChatClient::setReconnect(bool enabled, int initial_delay_ms, int max_delay_ms) {
+    reconnect_enabled_ = enabled;
+    initial_delay_ms_ = initial_delay_ms;
+    max_delay_ms_ = max_delay_ms;
+}
+
+AsyncChatClient::ConnectionId AsyncChatClient::addConnection(const std::string& host, int port) {
+    std::unique_ptr<Connection> conn(new Connection());
+
+    if (host.compare(0, 5, "unix:") == 0) {
+        std::string path = host.substr(5);
+        struct sockaddr_un* un = reinterpret_cast<struct sockaddr_un*>(&conn->addr);
+        if (path.size() >= sizeof(un->sun_path)) {
+            throw std::runtime_error("Caminho do socket local longo demais.");
+        }
+        un->sun_family = AF_UNIX;
+        strncpy(un->sun_path, path.c_str(), sizeof(un->sun_path) - 1);
+        conn->addr_len = sizeof(struct sockaddr_un);
+        conn->description = host;
+    } else {
+        // Resolve uma vez aqui; as reconexões reutilizam o endereço
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* res = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0 || res == nullptr) {
+            TSLOG(ERROR, "Endereço inválido: " + host);
+            throw std::runtime_error("Endereço inválido: " + host);
+        }
+        memcpy(&conn->addr, res->ai_addr, res->ai_addrlen);
+        conn->addr_len = res->ai_addrlen;
+        freeaddrinfo(res);
+        conn->description = host + ":" + std::to_string(port);
+    }
+
+    ConnectionId id;
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        id = next_id_++;
+        conn->id = id;
+        pending_adds_[id] = std::move(conn);
+        commands_.push_back(Command{Command::ADD, id, std::string()});
+    }
+    wake();
+    return id;
+}
+
+void AsyncChatClient::send(ConnectionId id, const std::string& message) {
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        commands_.push_back(Command{Command::SEND, id, message + "\n"});
+        drained_ = false;
+    }
+    wake();
+}
+
+bool AsyncChatClient::drain(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(commands_mutex_);
+    return drained_cv_.wait_for(lock, timeout, [this] { return drained_; });
+}
+
+void AsyncChatClient::closeConnection(ConnectionId id) {
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        commands_.push_back(Command{Command::CLOSE, id, std::string()});
+    }
+    wake();
+}
+
+void AsyncChatClient::wake() {
+    uint64_t one = 1;
+    ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+    (void)n; // EAGAIN: o contador já está pendente, o loop vai acordar de qualquer forma
+}
+
+void AsyncChatClient::start() {
+    if (running_.exchange(true)) return;
+    loop_thread_ = std::thread(&AsyncChatClient::loop, this);
+}
+
+void AsyncChatClient::stop() {
+    if (running_.exchange(false)) {
+        wake();
+        if (loop_thread_.joinable()) loop_thread_.join();
+    }
+    for (auto& p : connections_) {
+        dropConnection(*p.second, false);
+    }
+    connections_.clear();
+}
+
+// Aplica os pedidos das outras threads. Todos os SENDs de uma rodada são
+// concatenados antes do flush: vários envios viram um único send().
+void AsyncChatClient::drainCommands() {
+    std::vector<Command> commands;
+    std::map<ConnectionId, std::unique_ptr<Connection>> adds;
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        commands.swap(commands_);
+        adds.swap(pending_adds_);
+    }
+
+    std::vector<Connection*> touched;
+    for (auto& cmd : commands) {
+        if (cmd.kind == Command::ADD) {
+            auto it = adds.find(cmd.id);
+            if (it == adds.end()) continue;
+            Connection& conn = *it->second;
+            connections_[cmd.id] = std::move(it->second);
+            beginConnect(conn);
+            continue;
+        }
+
+        auto it = connections_.find(cmd.id);
+        if (it == connections_.end()) continue;
+        Connection& conn = *it->second;
+
+        if (cmd.kind == Command::SEND) {
+            if (conn.state == State::CLOSED) continue;
+            conn.out_buffer += cmd.payload;
+            touched.push_back(&conn);
+        } else {
+            conn.closing = true;
+            touched.push_back(&conn);
+        }
+    }
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (Connection* conn : touched) {
+        if (conn->state == State::CONNECTED) {
+            flush(*conn);
+        } else if (conn->closing && conn->state == State::IDLE) {
+            // Sem conexão no momento: não há como entregar o que resta
+            dropConnection(*conn, false);
+        }
+    }
+}
+
+void AsyncChatClient::beginConnect(Connection& conn) {
+    if (conn.state == State::IDLE && conn.backoff_ms > 0) --retries_pending_;
+    conn.state = State::CONNECTING;
+    conn.fd = socket(conn.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn.fd < 0) {
+        TSLOG(ERROR, "Falha ao criar socket para " + conn.description);
+        dropConnection(conn, true);
+        return;
+    }
+
+    conn.events = EPOLLOUT;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = conn.events;
+    ev.data.u64 = conn.id;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn.fd, &ev);
+
+    if (connect(conn.fd, reinterpret_cast<struct sockaddr*>(&conn.addr), conn.addr_len) == 0) {
+        finishConnect(conn);
+    } else if (errno != EINPROGRESS) {
+        TSLOG(WARNING, "Falha ao conectar em " + conn.description + ": " + std::strerror(errno));
+        dropConnection(conn, true);
+    }
+}
+
+void AsyncChatClient::finishConnect(Connection& conn) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+        TSLOG(WARNING, "Falha ao conectar em " + conn.description + ": " + std::strerror(err));
+        dropConnection(conn, true);
+        return;
+    }
+
+    conn.state = State::CONNECTED;
+    conn.backoff_ms = 0;
+    ++connected_count_;
+    TSLOG(INFO, "Conexão " + std::to_string(conn.id) + " estabelecida com " + conn.description);
+
+    if (on_state_) on_state_(conn.id, true);
+    // O pedido de histórico vai antes do que ficou na fila durante a queda
+    if (history_on_connect_ > 0) {
+        std::string request = history_compress_ ? "/caps lz\n" : "";
+        request += "/history " + std::to_string(history_on_connect_) + "\n";
+        conn.out_buffer.insert(conn.out_offset, request);
+    }
+    // Retoma: o que ficou na fila durante a queda vai agora
+    flush(conn);
+    if (conn.state == State::CONNECTED) updateInterest(conn);
+}
+
+void AsyncChatClient::handleReadable(Connection& conn) {
+    char buffer[ASYNC_READ_SIZE];
+    bool lost = false;
+    while (true) {
+        ssize_t n = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            bool ok = conn.decoder.feed(buffer, static_cast<size_t>(n), [&](const std::string& line) {
+                if (on_message_) on_message_(conn.id, line);
+            });
+            if (!ok) {
+                TSLOG(ERROR, "Quadro inválido recebido na conexão " + std::to_string(conn.id));
+                lost = true;
+                break;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        lost = true; // EOF ou erro
+        break;
+    }
+
+    if (lost) {
+        // As linhas completas já foram entregues; reconecta
+        TSLOG(WARNING, "Conexão " + std::to_string(conn.id) + " perdida com " + conn.description);
+        dropConnection(conn, true);
+    }
+}
+
+void AsyncChatClient::flush(Connection& conn) {
+    while (conn.out_offset < conn.out_buffer.size()) {
+        ssize_t n = ::send(conn.fd, conn.out_buffer.data() + conn.out_offset,
+                           conn.out_buffer.size() - conn.out_offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.out_offset += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        dropConnection(conn, true);
+        return;
+    }
+
+    if (conn.out_offset == conn.out_buffer.size()) {
+        conn.out_buffer.clear();
+        conn.out_offset = 0;
+        if (conn.closing) {
+            dropConnection(conn, false);
+            return;
+        }
+    }
+    updateInterest(conn);
+}
+
+void AsyncChatClient::updateInterest(Connection& conn) {
+    uint32_t wanted = EPOLLIN | (conn.out_offset < conn.out_buffer.size() ? EPOLLOUT : 0);
+    if (wanted == conn.events) return;
+    conn.events = wanted;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = wanted;
+    ev.data.u64 = conn.id;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void AsyncChatClient::dropConnection(Connection& conn, bool retry) {
+    if (conn.state == State::IDLE && conn.backoff_ms > 0) --retries_pending_;
+    bool was_connected = conn.state == State::CONNECTED;
+    if (conn.fd >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+        ::close(conn.fd);
+        conn.fd = -1;
+    }
+    conn.events = 0;
+    conn.decoder.reset();
+
+    // Mensagens já escritas saem da fila; uma mensagem escrita pela metade é reenviada inteira
+    size_t boundary = conn.out_offset == 0 ? std::string::npos : conn.out_buffer.rfind('\n', conn.out_offset - 1);
+    conn.out_buffer.erase(0, boundary == std::string::npos ? 0 : boundary + 1);
+    conn.out_offset = 0;
+
+    if (was_connected) {
+        --connected_count_;
+        if (on_state_) on_state_(conn.id, false);
+    }
+
+    if (retry && reconnect_enabled_ && running_ && !conn.closing) {
+        conn.state = State::IDLE;
+        ++retries_pending_;
+        conn.backoff_ms = conn.backoff_ms == 0 ? initial_delay_ms_ : std::min(conn.backoff_ms * 2, max_delay_ms_);
+        // Jitter: espera entre metade e o total do backoff, para que as conexões que
+        // caíram juntas (queda do servidor) não voltem todas no mesmo instante
+        int half = conn.backoff_ms / 2;
+        int delay = half + std::uniform_int_distribution<int>(0, conn.backoff_ms - half)(rng_);
+        conn.retry_at = Clock::now() + std::chrono::milliseconds(delay);
+    } else {
+        conn.state = State::CLOSED;
+        ++closed_pending_;
+    }
+}
+
+int AsyncChatClient::nextTimeoutMs() {
+    int timeout = -1;
+    if (retries_pending_ == 0) return timeout;
+    auto now = Clock::now();
+    for (auto& p : connections_) {
+        if (p.second->state != State::IDLE) continue;
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(p.second->retry_at - now).count();
+        int wait = ms < 0 ? 0 : static_cast<int>(ms);
+        if (timeout < 0 || wait < timeout) timeout = wait;
+    }
+    return timeout;
+}
+
+void AsyncChatClient::loop() {
+    struct epoll_event events[ASYNC_MAX_EVENTS];
+
+    while (running_) {
+        int n = epoll_wait(epoll_fd_, events, ASYNC_MAX_EVENTS, nextTimeoutMs());
+        if (n < 0 && errno != EINTR) {
+            TSLOG(ERROR, "epoll_wait falhou no cliente assíncrono.");
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == 0) {
+                uint64_t count;
+                while (::read(wake_fd_, &count, sizeof(count)) > 0) {}
+                drainCommands();
+                continue;
+            }
+
+            auto it = connections_.find(events[i].data.u64);
+            if (it == connections_.end()) continue;
+            Connection& conn = *it->second;
+            uint32_t ev = events[i].events;
+
+            if (conn.state == State::CONNECTING) {
+                finishConnect(conn);
+                continue;
+            }
+            if (conn.state != State::CONNECTED) continue;
+            if (ev & (EPOLLIN | EPOLLHUP | EPOLLERR)) handleReadable(conn);
+            if (conn.state == State::CONNECTED && (ev & EPOLLOUT)) flush(conn);
+        }
+
+        // Reconexões vencidas (só varre as conexões se houver alguma esperando)
+        auto now = Clock::now();
+        for (auto& p : connections_) {
+            if (retries_pending_ == 0) break;
+            if (p.second->state == State::IDLE && p.second->retry_at <= now) {
+                beginConnect(*p.second);
+            }
+        }
+
+        // Remove as conexões encerradas nesta rodada
+        if (closed_pending_ > 0) {
+            for (auto it = connections_.begin(); it != connections_.end();) {
+                if (it->second->state == State::CLOSED) it = connections_.erase(it);
+                else ++it;
+            }
+            closed_pending_ = 0;
+        }
+
+        updateDrained();
+        if (on_idle_) on_idle_();
+    }
+}
+
+void AsyncChatClient::updateDrained() {
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        if (drained_ || !commands_.empty()) return;
+    }
+    for (auto& p : connections_) {
+        if (p.second->state != State::CLOSED && !p.second->out_buffer.empty()) return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        if (!commands_.empty()) return;
+        drained_ = true;
+    }
+    drained_cv_.notify_all();
+}
+
+AsyncChatClient::~AsyncChatClient() {
+    stop();
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+}
@@ -0,0 +1,140 @@
+#ifndef ASYNC_CHAT_CLIENT_H
+#define ASYNC_CHAT_CLIENT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/socket.h>
+#include "../libtslog/tslog.h"
+#include "FrameCodec.h"
+
+// Cliente orientado a eventos: uma única thread (epoll) atende muitas conexões
+// não bloqueantes. Os envios são enfileirados e agrupados em um send() por
+// rodada do loop; conexões que caem são refeitas com backoff exponencial (com
+// jitter) e reenviam o que ainda não tinha sido escrito.
+class AsyncChatClient {
+public:
+    using ConnectionId = size_t;
+    using MessageHandler = std::function<void(ConnectionId id, const std::string& line)>;
+    using StateHandler = std::function<void(ConnectionId id, bool connected)>;
+    using IdleHandler = std::function<void()>;
+
+    AsyncChatClient();
+
+    AsyncChatClient(const AsyncChatClient&) = delete;
+    AsyncChatClient& operator=(const AsyncChatClient&) = delete;
+
+    // Callbacks são chamados na thread do loop; configurar antes de start()
+    void setMessageHandler(MessageHandler handler) { on_message_ = std::move(handler); }
+    void setStateHandler(StateHandler handler) { on_state_ = std::move(handler); }
+    // Chamado ao fim de cada rodada do loop (ex.: dar flush na saída uma vez só)
+    void setIdleHandler(IdleHandler handler) { on_idle_ = std::move(handler); }
+
+    // Reconexão automática (ligada por padrão)
+    void setReconnect(bool enabled, int initial_delay_ms = 100, int max_delay_ms = 5000);
+
+    // A cada conexão (e reconexão) pede as últimas n mensagens do histórico,
+    // num lote comprimido se compress; 0 desliga. Configurar antes de start()
+    void setHistoryOnConnect(size_t n, bool compress = true) { history_on_connect_ = n; history_compress_ = compress; }
+
+    // Registra uma conexão; "unix:/caminho" como host usa AF_UNIX (porta ignorada).
+    // A conexão é feita de forma assíncrona pelo loop.
+    ConnectionId addConnection(const std::string& host, int port);
+
+    // Enfileira uma mensagem (thread-safe; não bloqueia)
+    void send(ConnectionId id, const std::string& message);
+
+    // Espera até tudo o que foi enviado ser aceito pelo kernel (ou o timeout vencer)
+    bool drain(std::chrono::milliseconds timeout);
+
+    // Fecha uma conexão sem reconectar, depois de escrever o que já estava na fila
+    void closeConnection(ConnectionId id);
+
+    // Roda o loop numa thread própria / encerra e junta a thread
+    void start();
+    void stop();
+
+    size_t getConnectedCount() const { return connected_count_; }
+
+    ~AsyncChatClient();
+
+private:
+    enum class State { IDLE, CONNECTING, CONNECTED, CLOSED };
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        ConnectionId id = 0;
+        std::string description;
+        sockaddr_storage addr{};
+        socklen_t addr_len = 0;
+        int fd = -1;
+        State state = State::IDLE;
+        uint32_t events = 0;         // máscara registrada no epoll
+        FrameCodec decoder;          // linhas recebidas, desmontando os lotes "@batch"
+        std::string out_buffer;      // mensagens ainda não escritas ("...\n...\n")
+        size_t out_offset = 0;       // bytes de out_buffer já aceitos pelo kernel
+        int backoff_ms = 0;
+        Clock::time_point retry_at;
+        bool closing = false;        // closeConnection() pedido: fecha quando a fila esvaziar
+    };
+
+    // Pedidos vindos de outras threads, aplicados pelo loop
+    struct Command {
+        enum Kind { ADD, SEND, CLOSE } kind;
+        ConnectionId id;
+        std::string payload;
+    };
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1; // eventfd para acordar o epoll_wait
+
+    std::mutex commands_mutex_;
+    std::vector<Command> commands_;
+    std::condition_variable drained_cv_;
+    bool drained_ = true; // nada na fila nem nos buffers de saída (protegido por commands_mutex_)
+    std::map<ConnectionId, std::unique_ptr<Connection>> pending_adds_; // protegido por commands_mutex_
+
+    std::map<ConnectionId, std::unique_ptr<Connection>> connections_; // só a thread do loop
+    ConnectionId next_id_ = 1;
+    size_t retries_pending_ = 0; // conexões em IDLE esperando o backoff
+    size_t closed_pending_ = 0;  // conexões CLOSED ainda no mapa (removidas ao fim da rodada)
+
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> connected_count_{0};
+    std::thread loop_thread_;
+
+    bool reconnect_enabled_ = true;
+    int initial_delay_ms_ = 100;
+    int max_delay_ms_ = 5000;
+    std::mt19937 rng_{std::random_device{}()}; // jitter do backoff (só a thread do loop)
+    size_t history_on_connect_ = 0;
+    bool history_compress_ = true;
+
+    MessageHandler on_message_;
+    StateHandler on_state_;
+    IdleHandler on_idle_;
+
+    void loop();
+    void wake();
+    void drainCommands();
+    void beginConnect(Connection& conn);
+    void finishConnect(Connection& conn);
+    void handleReadable(Connection& conn);
+    void flush(Connection& conn);
+    void updateInterest(Connection& conn);
+    void dropConnection(Connection& conn, bool retry);
+    int nextTimeoutMs();
+    void updateDrained();
+};
+
+#endif // ASYNC_CHAT_CLIENT_H
@@ -4,9 +4,16 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/un.h>
 #include <cstring>
+#include <chrono>
+#include <sys/time.h>
 
 #define BUFFER_SIZE 1024
+// Espera pela resposta do servidor ao "/shm"
+#define SHM_REPLY_TIMEOUT_MS 2000
+// Anel cheio por mais que isto: o servidor parou de consumir, volta ao socket
+#define SHM_FULL_TIMEOUT_MS 5000
 
 ChatClient::ChatClient() {
     TSLOG(INFO, "Cliente CLI inicializado.");
@@ -45,19 +52,123 @@ void ChatClient::connectToServer(const std::string& ip, int port) {
         throw std::runtime_error("Falha na conexão.");
     }
 
+    onConnected(ip + ":" + std::to_string(port));
+}
+
+void ChatClient::connectToUnix(const std::string& path) {
+    if (connected_) {
+        TSLOG(WARNING, "Já conectado. Desconecte antes de tentar novamente.");
+        return;
+    }
+
+    struct sockaddr_un server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(server_addr.sun_path)) {
+        TSLOG(ERROR, "Caminho do socket local longo demais: " + path);
+        throw std::runtime_error("Caminho do socket local inválido.");
+    }
+    strncpy(server_addr.sun_path, path.c_str(), sizeof(server_addr.sun_path) - 1);
+
+    client_socket_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client_socket_fd_ < 0) {
+        TSLOG(ERROR, "Falha ao criar socket local do cliente.");
+        throw std::runtime_error("Falha ao criar socket.");
+    }
+
+    if (connect(client_socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        TSLOG(ERROR, "Falha na conexão com o socket local " + path);
+        close(client_socket_fd_);
+        throw std::runtime_error("Falha na conexão.");
+    }
+
+    onConnected("unix:" + path);
+}
+
+void ChatClient::onConnected(const std::string& description) {
     connected_ = true;
-    TSLOG(INFO, "Conectado com sucesso ao servidor " + ip + ":" + std::to_string(port));
+    TSLOG(INFO, "Conectado com sucesso ao servidor " + description);
 
     // 4. Inicia a thread de recebimento
     receiver_thread_ = std::thread(&ChatClient::receiverLoop, this);
 }
 
+bool ChatClient::enableSharedMemory(size_t capacity) {
+    if (!connected_) return false;
+    if (shm_ring_) return true;
+
+    // O servidor só aceita o anel de clientes no socket local
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getsockname(client_socket_fd_, (struct sockaddr*)&peer, &peer_len) < 0 || peer.ss_family != AF_UNIX) {
+        TSLOG(WARNING, "Memória compartilhada só funciona sobre o socket local (connectToUnix).");
+        return false;
+    }
+
+    std::string name = "/chat_shm_" + std::to_string(getpid()) + "_" + std::to_string(client_socket_fd_);
+    std::unique_ptr<ShmRing> ring = ShmRing::create(name, capacity);
+    {
+        std::lock_guard<std::mutex> lock(shm_mutex_);
+        shm_reply_ = ShmReply::NONE;
+    }
+
+    // O anúncio vai pelo socket; as mensagens só vão pelo anel depois do "@shm ok"
+    std::string announce = "/shm " + name + "\n";
+    if (send(client_socket_fd_, announce.c_str(), announce.length(), 0) < 0) {
+        TSLOG(ERROR, "Falha ao anunciar memória compartilhada.");
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(shm_mutex_);
+    shm_cv_.wait_for(lock, std::chrono::milliseconds(SHM_REPLY_TIMEOUT_MS),
+                     [this] { return shm_reply_ != ShmReply::NONE || !connected_; });
+    if (shm_reply_ != ShmReply::OK) {
+        // O anel sai de escopo e o segmento é removido
+        TSLOG(WARNING, "Servidor não aceitou a memória compartilhada (" + name + "); envio continua pelo socket.");
+        return false;
+    }
+    shm_ring_ = std::move(ring);
+    TSLOG(INFO, "Envio por memória compartilhada habilitado (" + name + ")");
+    return true;
+}
+
+void ChatClient::requestHistory(size_t n, bool compress) {
+    if (!connected_) return;
+
+    // Com o anel ativo o pedido vai por ele, atrás do chat já enviado
+    if (shm_ring_) {
+        if (compress) sendMessage("/caps lz");
+        sendMessage("/history " + std::to_string(n));
+        return;
+    }
+
+    std::string request = compress ? "/caps lz\n" : "";
+    request += "/history " + std::to_string(n) + "\n";
+    if (send(client_socket_fd_, request.c_str(), request.length(), 0) < 0) {
+        TSLOG(ERROR, "Falha ao pedir o histórico.");
+    }
+}
+
 void ChatClient::sendMessage(const std::string& message) {
     if (!connected_) {
         std::cout << "ERRO: Não conectado. Use /connect primeiro." << std::endl;
         return;
     }
     
+    if (shm_ring_ && message.size() + sizeof(uint32_t) <= shm_ring_->getCapacity()) {
+        // Anel cheio: o servidor está atrasado, espera espaço sem reordenar mensagens
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHM_FULL_TIMEOUT_MS);
+        while (connected_ && !shm_ring_->push(message)) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                TSLOG(ERROR, "Anel de memória compartilhada parado; envio volta ao socket.");
+                shm_ring_->markClosed();
+                shm_ring_.reset();
+                break;
+            }
+            std::this_thread::yield();
+        }
+        if (shm_ring_) return;
+    }
+
     // Adiciona uma quebra de linha para o servidor identificar o fim da mensagem
     std::string msg_with_newline = message + "\n";
     
@@ -73,15 +184,37 @@ void ChatClient::sendMessage(const std::string& message) {
 void ChatClient::receiverLoop() {
     char buffer[BUFFER_SIZE];
     int bytes_read;
+    FrameCodec decoder; // linhas, desmontando os lotes "@batch" do servidor
+    std::string output;
     
     TSLOG(INFO, "Thread de recebimento iniciada.");
 
-    while (connected_ && (bytes_read = read(client_socket_fd_, buffer, BUFFER_SIZE - 1)) > 0) {
-        buffer[bytes_read] = '\0';
-        std::string received_data(buffer);
-        
-        // **Saída Amigável no CLI:** Imprime a mensagem recebida sem o prefixo de log
-        std::cout << received_data << std::flush;
+    while (connected_ && (bytes_read = read(client_socket_fd_, buffer, BUFFER_SIZE)) > 0) {
+        bool ok = decoder.feed(buffer, static_cast<size_t>(bytes_read), [&](const std::string& line) {
+            // Resposta ao "/shm": acorda o enableSharedMemory() que está esperando
+            if (line.compare(0, 5, "@shm ") == 0) {
+                std::lock_guard<std::mutex> lock(shm_mutex_);
+                shm_reply_ = line == "@shm ok" ? ShmReply::OK : ShmReply::REFUSED;
+                shm_cv_.notify_all();
+                return;
+            }
+            if (on_message_) {
+                on_message_(line);
+            } else {
+                output += line;
+                output += '\n';
+            }
+        });
+
+        // **Saída Amigável no CLI:** todas as linhas completas de uma vez
+        if (!output.empty()) {
+            std::cout << output << std::flush;
+            output.clear();
+        }
+        if (!ok) {
+            TSLOG(ERROR, "Quadro inválido recebido do servidor.");
+            break;
+        }
     }
 
     // Se o loop terminou
@@ -89,26 +222,38 @@ void ChatClient::receiverLoop() {
         TSLOG(WARNING, "Conexão perdida com o servidor.");
         connected_ = false;
     }
+    {
+        std::lock_guard<std::mutex> lock(shm_mutex_);
+        shm_cv_.notify_all();
+    }
 }
 
 void ChatClient::disconnect() {
     if (connected_) {
-        // Indica que não vamos enviar mais dados (fecha escrita), mas mantém a leitura
         connected_ = false;
+        if (shm_ring_) {
+            shm_ring_->markClosed();
+        }
         if (client_socket_fd_ >= 0) {
-            // Fecha metade da conexão para sinalizar ao servidor que não vamos enviar mais
+            // Fecha metade da conexão para sinalizar ao servidor que não vamos enviar mais.
+            // O servidor fecha o socket em seguida e o read() da recepção retorna 0; o
+            // timeout só limita a espera se o servidor não responder.
+            struct timeval timeout = {0, 200 * 1000};
+            setsockopt(client_socket_fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
             ::shutdown(client_socket_fd_, SHUT_WR);
-            // Dá um pequeno tempo para que a thread de recepção leia mensagens pendentes
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
-            ::close(client_socket_fd_);
-            client_socket_fd_ = -1;
-            TSLOG(INFO, "Conexão fechada.");
         }
+    }
 
-        // Tenta juntar a thread de recebimento (se estiver rodando)
-        if (receiver_thread_.joinable()) {
-            receiver_thread_.join(); 
-        }
+    // Junta a thread de recebimento (também quando a conexão já tinha caído)
+    // antes de fechar o descritor que ela usa
+    if (receiver_thread_.joinable()) {
+        receiver_thread_.join(); 
+    }
+
+    if (client_socket_fd_ >= 0) {
+        ::close(client_socket_fd_);
+        client_socket_fd_ = -1;
+        TSLOG(INFO, "Conexão fechada.");
     }
 }
 
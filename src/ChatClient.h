@@ -3,27 +3,65 @@
 
 #include <string>
 #include <thread>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <unistd.h>
 #include "../libtslog/tslog.h" 
+#include "ShmRing.h"
+#include "FrameCodec.h"
 
+// Cliente bloqueante de uma conexão (uma thread de recepção).
+// Para muitas conexões por thread, ver AsyncChatClient.
 class ChatClient {
+public:
+    using MessageHandler = std::function<void(const std::string& line)>;
+
 private:
     int client_socket_fd_ = -1;
-    bool connected_ = false;
+    std::atomic<bool> connected_{false};
     std::thread receiver_thread_;
+    std::unique_ptr<ShmRing> shm_ring_; // transporte de envio opcional (só AF_UNIX)
+    MessageHandler on_message_;         // vazio = imprime no stdout
+
+    // Resposta do servidor ao "/shm" ("@shm ok" ou "@shm refused"), vinda da thread de recepção
+    enum class ShmReply { NONE, OK, REFUSED };
+    std::mutex shm_mutex_;
+    std::condition_variable shm_cv_;
+    ShmReply shm_reply_ = ShmReply::NONE;
 
     // Loop que escuta e exibe mensagens do servidor
     void receiverLoop(); 
 
+    // Passos comuns depois do connect() (TCP ou local)
+    void onConnected(const std::string& description);
+
 public:
     ChatClient();
 
+    // Recebe cada linha vinda do servidor (na thread de recepção); chamar antes de conectar
+    void setMessageHandler(MessageHandler handler) { on_message_ = std::move(handler); }
+
     // Conecta o socket ao IP e porta do servidor
     void connectToServer(const std::string& ip, int port);
 
+    // Conecta ao socket local (AF_UNIX) do servidor
+    void connectToUnix(const std::string& path);
+
+    // Passa a enviar as mensagens por um anel em memória compartilhada.
+    // Só funciona sobre connectToUnix; as respostas continuam chegando pelo socket.
+    // Devolve false (e continua no socket) se o servidor recusar ou não responder.
+    bool enableSharedMemory(size_t capacity = ShmRing::DEFAULT_CAPACITY);
+
     // Envia uma mensagem para o servidor
     void sendMessage(const std::string& message);
 
+    // Pede as últimas n mensagens do histórico; chegam num único lote (comprimido
+    // se compress) e são entregues linha a linha como as outras mensagens
+    void requestHistory(size_t n, bool compress = true);
+
     // Fecha o socket e encerra a thread
     void disconnect();
 
@@ -1,9 +1,11 @@
 #include "ChatServer.h"
 #include "ClientSession.h"
+#include "MemoryStats.h"
 #include "MessageHistory.h"
 #include <unistd.h>      // close()
 #include <sys/socket.h>  // socket, bind, listen, accept
 #include <netinet/in.h>  // sockaddr_in
+#include <sys/un.h>      // sockaddr_un
 #include <arpa/inet.h>   // inet_ntoa
 #include <cstring>       // memset
 #include <stdexcept>
@@ -11,11 +13,22 @@
 
 // Inicializa o ClientManager e a porta
 // Em chat_multiusuario/src/ClientSession.cpp (Linha 22, onde o erro ocorre)
-ChatServer::ChatServer(int port) : port_(port) {
+ChatServer::ChatServer(int port) : ChatServer(ServerOptions{port}) {}
+
+ChatServer::ChatServer(const ServerOptions& options) : port_(options.port), options_(options) {
     // Inicializa o ClientManager e o novo Monitor MessageHistory
     client_manager_ = std::make_shared<ClientManager>();
     message_history_ = std::make_shared<MessageHistory>();
-    TSLOG(INFO, "Servidor inicializado na porta " + std::to_string(port) + ".");
+    if (!options_.capture_path.empty()) {
+        capture_ = std::make_shared<TrafficCapture>(options_.capture_path);
+        client_manager_->setCapture(capture_);
+    }
+    client_manager_->getPresence().setWindow(std::chrono::milliseconds(options_.presence_window_ms));
+    if (options_.fanout_workers > 0) {
+        client_manager_->configureFanout(options_.fanout_workers, options_.fanout_threshold, options_.fanout_chunk_size);
+    }
+    MemoryStats::setLimit(options_.max_memory_bytes);
+    TSLOG(INFO, "Servidor inicializado na porta " + std::to_string(port_) + ".");
     // Ignorar SIGPIPE globalmente: evita que writes para sockets fechados derrubem o processo
     signal(SIGPIPE, SIG_IGN);
 }
@@ -58,9 +71,12 @@ void ChatServer::start() {
     }
 
     TSLOG(INFO, "Servidor TCP escutando em 0.0.0.0:" + std::to_string(port_));
+
+    startUnixListener();
+    startFederation();
     
     // Lança a thread principal de aceitação (requisito: threads)
-    acceptor_thread_ = std::thread(&ChatServer::startAcceptLoop, this);
+    acceptor_thread_ = std::thread(&ChatServer::startAcceptLoop, this, server_socket_fd_);
     
     // Mantém a thread principal da aplicação viva, esperando a thread de aceitação
     if (acceptor_thread_.joinable()) {
@@ -68,14 +84,68 @@ void ChatServer::start() {
     }
 }
 
-// Loop principal que aceita e despacha clientes para novas threads
-void ChatServer::startAcceptLoop() {
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
+// Listener AF_UNIX: mesmos ClientSession/ClientManager, sem a pilha TCP de loopback
+void ChatServer::startUnixListener() {
+    if (options_.unix_path.empty()) return;
+
+    struct sockaddr_un unix_addr;
+    memset(&unix_addr, 0, sizeof(unix_addr));
+    unix_addr.sun_family = AF_UNIX;
+    if (options_.unix_path.size() >= sizeof(unix_addr.sun_path)) {
+        TSLOG(ERROR, "Caminho do socket local longo demais: " + options_.unix_path);
+        throw std::runtime_error("Caminho do socket local longo demais.");
+    }
+    strncpy(unix_addr.sun_path, options_.unix_path.c_str(), sizeof(unix_addr.sun_path) - 1);
+
+    unix_socket_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (unix_socket_fd_ < 0) {
+        TSLOG(ERROR, "Falha ao criar socket local.");
+        throw std::runtime_error("Falha ao criar socket local.");
+    }
+
+    // Remove um socket antigo deixado por uma execução anterior
+    unlink(options_.unix_path.c_str());
+    if (bind(unix_socket_fd_, (struct sockaddr*)&unix_addr, sizeof(unix_addr)) < 0 ||
+        listen(unix_socket_fd_, 5) < 0) {
+        TSLOG(ERROR, "Falha ao escutar no socket local " + options_.unix_path);
+        close(unix_socket_fd_);
+        unix_socket_fd_ = -1;
+        throw std::runtime_error("Falha ao escutar no socket local.");
+    }
+
+    TSLOG(INFO, "Servidor escutando no socket local " + options_.unix_path);
+    unix_acceptor_thread_ = std::thread(&ChatServer::startAcceptLoop, this, unix_socket_fd_);
+}
+
+// Liga este nó aos outros servidores, se configurado
+void ChatServer::startFederation() {
+    if (options_.peer_port <= 0 && options_.peers.empty()) return;
+
+    std::string node_id = options_.node_id.empty() ? "node-" + std::to_string(port_) : options_.node_id;
+    federation_ = std::make_shared<FederationManager>(node_id, client_manager_, message_history_);
+    client_manager_->setFederation(federation_);
+
+    if (options_.peer_port > 0) {
+        federation_->listen(options_.peer_bind, options_.peer_port);
+    }
+    for (const auto& peer : options_.peers) {
+        size_t colon = peer.rfind(':');
+        if (colon == std::string::npos) {
+            TSLOG(ERROR, "Par inválido (esperado host:porta): " + peer);
+            throw std::runtime_error("Par inválido: " + peer);
+        }
+        federation_->connectTo(peer.substr(0, colon), std::stoi(peer.substr(colon + 1)));
+    }
+}
 
+// Loop principal que aceita e despacha clientes para novas threads
+void ChatServer::startAcceptLoop(int listen_fd) {
     while (true) {
+        struct sockaddr_storage client_addr;
+        socklen_t client_len = sizeof(client_addr);
+
         // 5. Accept
-        int client_socket = accept(server_socket_fd_, (struct sockaddr*)&client_addr, &client_len);
+        int client_socket = accept(listen_fd, (struct sockaddr*)&client_addr, &client_len);
         
         if (client_socket < 0) {
             // Em um sistema real, você checaria errno. Aqui, apenas logamos e continuamos
@@ -83,20 +153,49 @@ void ChatServer::startAcceptLoop() {
             continue;
         }
 
-        std::string client_ip = inet_ntoa(client_addr.sin_addr);
-        TSLOG(INFO, "Nova conexão aceita de: " + client_ip + " no socket: " + std::to_string(client_socket));
+        std::string client_ip = "local";
+        if (client_addr.ss_family == AF_INET) {
+            client_ip = inet_ntoa(((struct sockaddr_in*)&client_addr)->sin_addr);
+        }
+        TSLOGF(INFO, "Nova conexão aceita de: {} no socket: {}", client_ip, client_socket);
+
+        // Servidor cheio: avisa e fecha antes de criar a sessão (e suas threads)
+        bool too_many = options_.max_connections > 0 &&
+                        client_manager_->getActiveCount() >= options_.max_connections;
+        if (too_many || MemoryStats::isOverLimit()) {
+            static const char FULL[] = "*** Servidor cheio, tente mais tarde\n";
+            send(client_socket, FULL, sizeof(FULL) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            close(client_socket);
+            MemoryStats::countRejectedConnection();
+            TSLOGF(WARNING, "Conexão de {} recusada ({})", client_ip,
+                   too_many ? "limite de conexões" : "limite de memória");
+            continue;
+        }
+
+        if (options_.socket_send_buffer > 0) {
+            int sndbuf = options_.socket_send_buffer;
+            setsockopt(client_socket, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        }
 
         // 6. Cria e Inicia a Thread de Sessão (requisito: Cada cliente atendido por thread)
         try {
             auto session = std::make_shared<ClientSession>(
                 client_socket, 
                 client_manager_,
-                message_history_
+                message_history_,
+                options_.max_backlog_bytes
             );
             
-            session->start();
-            // A ClientManager gerencia a lista de sessões/sockets (protegida por mutex)
-            client_manager_->addClient(session); 
+            // A ClientManager gerencia a lista de sessões/sockets (protegida por mutex).
+            // Entra na lista (e na presença) antes da thread ler: um /nick ou uma
+            // desconexão imediata já encontram a sessão registrada
+            client_manager_->addClient(session);
+            try {
+                session->start();
+            } catch (...) {
+                client_manager_->removeClient(client_socket);
+                throw;
+            }
         } catch (const std::exception& e) {
             TSLOG(ERROR, "Falha ao iniciar thread da sessão: " + std::string(e.what()));
             close(client_socket);
@@ -105,9 +204,19 @@ void ChatServer::startAcceptLoop() {
 }
 
 ChatServer::~ChatServer() {
+    if (federation_) {
+        federation_->stop();
+    }
     if (server_socket_fd_ >= 0) {
         close(server_socket_fd_);
     }
+    if (unix_socket_fd_ >= 0) {
+        close(unix_socket_fd_);
+        unlink(options_.unix_path.c_str());
+    }
+    if (unix_acceptor_thread_.joinable()) {
+        unix_acceptor_thread_.detach();
+    }
     if (acceptor_thread_.joinable()) {
         // Nota: Em produção, você faria um 'detach' ou usaria um flag para encerrar o loop.
         // Aqui, forçaremos o join para a demo da Etapa 2.
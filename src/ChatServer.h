@@ -11,22 +11,71 @@
 #include "ClientSession.h"
 #include "ClientManager.h"
 #include "MessageHistory.h"
+#include "FederationManager.h"
+#include "TrafficCapture.h"
 // ... (outros headers de arquitetura)
 
+// Configuração do servidor (preenchida a partir da linha de comando em main_server)
+struct ServerOptions {
+    int port = 8080;
+
+    // Listener AF_UNIX adicional para clientes na mesma máquina (vazio = desligado)
+    std::string unix_path;
+
+    // Bytes de chat enfileirados por cliente lento antes de descartar (controle nunca é descartado)
+    size_t max_backlog_bytes = ClientSession::DEFAULT_MAX_BACKLOG;
+
+    // SO_SNDBUF de cada cliente (0 = padrão do kernel). Pequeno, para que o
+    // acúmulo fique na fila com prioridades e não no buffer FIFO do kernel
+    int socket_send_buffer = 64 * 1024;
+
+    // Fanout paralelo: 0 workers = sempre na thread da sessão remetente. Com um
+    // núcleo só o pool não tem o que paralelizar e fica desligado.
+    size_t fanout_workers = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() : 0;
+    size_t fanout_threshold = 2048;  // destinatários mínimos para usar o pool
+    size_t fanout_chunk_size = 512;  // destinatários por tarefa
+
+    // Janela em que as entradas/saídas são agregadas num único delta de presença
+    int presence_window_ms = PresenceService::DEFAULT_WINDOW_MS;
+
+    // Limites de carga (0 = sem limite). Acima deles novas conexões são recusadas;
+    // acima do limite de memória o chat (BULK) também deixa de ser enfileirado.
+    // A memória é a estimativa de heap do MemoryStats (sem as pilhas das threads)
+    size_t max_connections = 0;
+    size_t max_memory_bytes = 0;
+
+    // Grava o tráfego de entrada neste arquivo (vazio = desligado); ver chat_replay
+    std::string capture_path;
+
+    // Federação: liga-se quando há porta de pares ou pares de saída
+    std::string node_id;             // vazio = "node-<port>"
+    int peer_port = 0;               // 0 = não escuta outros nós
+    std::string peer_bind = "127.0.0.1"; // endereço da porta de pares (não há autenticação)
+    std::vector<std::string> peers;  // "host:porta" da porta de pares de outros nós
+};
+
 class ChatServer {
 private:
     int server_socket_fd_ = -1;
+    int unix_socket_fd_ = -1;
     int port_;
+    ServerOptions options_;
     
     std::shared_ptr<ClientManager> client_manager_;
     std::shared_ptr<MessageHistory> message_history_;
+    std::shared_ptr<FederationManager> federation_;
+    std::shared_ptr<TrafficCapture> capture_;
     
     std::thread acceptor_thread_; // <--- CORREÇÃO 2: std::thread agora funciona
+    std::thread unix_acceptor_thread_;
 
-    void startAcceptLoop();
+    void startAcceptLoop(int listen_fd);
+    void startUnixListener();
+    void startFederation();
 
 public:
     ChatServer(int port);
+    ChatServer(const ServerOptions& options);
     void start();
     void stop();
     ~ChatServer();
@@ -1,39 +1,61 @@
 #include "ClientManager.h"
 #include "ClientSession.h"
+#include "FederationManager.h"
+#include "MemoryStats.h"
+#include "TrafficCapture.h"
 #include "../libtslog/tslog.h"
 #include <unistd.h> // write, close, close
 #include <sys/socket.h> // shutdown, SHUT_RDWR
 #include <sstream>
 #include <vector>
+#include <algorithm>
+
+// Um nó do mapa de sessões (cabeçalho + par fd/shared_ptr)
+static const int64_t SESSION_NODE_BYTES =
+    MemoryStats::MAP_NODE_OVERHEAD + sizeof(std::pair<const int, std::shared_ptr<ClientSession>>);
 
 // Adaptação: Agora armazena o shared_ptr para a sessão
 void ClientManager::addClient(std::shared_ptr<ClientSession> session) {
-    std::lock_guard<std::mutex> lock(list_mutex_); // Exclusão Mútua
     int socket_fd = session->getSocket();
     std::string username = session->getUsername();
-    
-    sessions_[socket_fd] = session;
-    
-    TSLOG(INFO, "Cliente " + username + " (socket: " + std::to_string(socket_fd) + ") adicionado. Total: " + std::to_string(sessions_.size()));
+    if (capture_) capture_->record(CaptureEvent::JOIN, session->getSessionId());
+    {
+        std::lock_guard<std::mutex> lock(list_mutex_); // Exclusão Mútua
+        auto inserted = sessions_.insert(std::make_pair(socket_fd, session));
+        if (inserted.second) {
+            MemoryStats::add(MemoryCategory::REGISTRY, SESSION_NODE_BYTES);
+        } else {
+            inserted.first->second = session;
+        }
+        TSLOGF(INFO, "Cliente {} (socket: {}) adicionado. Total: {}", username, socket_fd, sessions_.size());
+    }
+    presence_.join(session);
 }
 
 void ClientManager::removeClient(int socket_fd) {
-    std::lock_guard<std::mutex> lock(list_mutex_); // Exclusão Mútua
-    auto it = sessions_.find(socket_fd);
-    if (it != sessions_.end()) {
-        TSLOG(INFO, "Cliente (socket: " + std::to_string(socket_fd) + ") removido. Total: " + std::to_string(sessions_.size() - 1));
-        // Fecha o socket do cliente antes de remover a sessão para evitar races
+    uint64_t session_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(list_mutex_); // Exclusão Mútua
+        auto it = sessions_.find(socket_fd);
+        if (it == sessions_.end()) return;
+        session_id = it->second->getSessionId();
+        TSLOGF(INFO, "Cliente (socket: {}) removido. Total: {}", socket_fd, sessions_.size() - 1);
+        // Derruba a conexão antes de remover a sessão; o close() fica com a própria
+        // ClientSession, senão o número do fd poderia ser fechado duas vezes
         int fd = it->first;
-        try {
-            if (fd >= 0) {
-                ::shutdown(fd, SHUT_RDWR);
-                ::close(fd);
-            }
-        } catch (...) {
-            // não propagar exceções no gerenciador
+        if (fd >= 0) {
+            ::shutdown(fd, SHUT_RDWR);
         }
         sessions_.erase(it);
+        MemoryStats::sub(MemoryCategory::REGISTRY, SESSION_NODE_BYTES);
     }
+    onSessionRemoved(session_id);
+}
+
+// Depois de tirar a sessão do mapa (fora do lock): saída na captura e na presença
+void ClientManager::onSessionRemoved(uint64_t session_id) {
+    if (capture_) capture_->record(CaptureEvent::LEAVE, session_id);
+    presence_.leave(session_id);
 }
 
 // Funções de formatação e iteração de broadcast
@@ -64,26 +86,97 @@ void ClientManager::broadcastMessage(int from_socket, const std::string &message
 
     // 2. ENVIAR FORA DO LOCK (I/O)
     std::string formatted_message = sender_name + ": " + message + "\n";
-    std::vector<int> to_remove;
+    sendAndPrune(sessions_copy, formatted_message, MessagePriority::BULK, sender_name);
+
+    // 3. Repassa para os outros nós da federação, se houver
+    if (auto federation = federation_.lock()) {
+        federation->publish(sender_name, message);
+    }
+}
+
+void ClientManager::recordInbound(uint64_t session_id, const std::string& line) {
+    if (capture_) capture_->record(CaptureEvent::MESSAGE, session_id, line);
+}
+
+void ClientManager::deliverRemote(const std::string& sender_name, const std::string& message) {
+    std::vector<std::shared_ptr<ClientSession>> sessions_copy;
+    {
+        std::lock_guard<std::mutex> lg(list_mutex_);
+        for (const auto &p : sessions_) {
+            sessions_copy.push_back(p.second);
+        }
+    }
+    sendAndPrune(sessions_copy, sender_name + ": " + message + "\n", MessagePriority::BULK, sender_name);
+}
 
-    for (auto &sess : sessions_copy) {
-        if (!sess) continue;
-        // Se o envio falhar (socket fechado), adiciona à lista de remoção
-        if (!sess->sendMessage(formatted_message)) {
-            to_remove.push_back(sess->getSocket());
+// Envia fora do lock; se algum send falhar, remove a sessão depois (sob lock).
+void ClientManager::sendAndPrune(const std::vector<std::shared_ptr<ClientSession>>& sessions_copy,
+                                 const std::string& formatted_message,
+                                 MessagePriority priority,
+                                 const std::string& sender) {
+    std::vector<std::shared_ptr<ClientSession>> to_remove;
+
+    if (fanout_pool_ && sessions_copy.size() >= fanout_threshold_) {
+        // Divide o snapshot em pedaços; cada pedaço coleta suas falhas localmente
+        size_t chunks = (sessions_copy.size() + fanout_chunk_size_ - 1) / fanout_chunk_size_;
+        std::vector<std::vector<std::shared_ptr<ClientSession>>> failed(chunks);
+        std::vector<FanoutPool::Task> tasks;
+        tasks.reserve(chunks);
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t begin = c * fanout_chunk_size_;
+            size_t end = std::min(begin + fanout_chunk_size_, sessions_copy.size());
+            tasks.push_back([&, c, begin, end] {
+                for (size_t i = begin; i < end; ++i) {
+                    const auto &sess = sessions_copy[i];
+                    if (sess && !sess->sendMessage(formatted_message, priority, sender)) {
+                        failed[c].push_back(sess);
+                    }
+                }
+            });
+        }
+        fanout_pool_->runAll(std::move(tasks));
+        for (const auto &f : failed) {
+            to_remove.insert(to_remove.end(), f.begin(), f.end());
+        }
+    } else {
+        for (auto &sess : sessions_copy) {
+            if (!sess) continue;
+            // Se o envio falhar (socket fechado), adiciona à lista de remoção
+            if (!sess->sendMessage(formatted_message, priority, sender)) {
+                to_remove.push_back(sess);
+            }
         }
     }
 
-    // 3. Aquirir o lock para REMOVER os clientes que falharam
+    // Aquirir o lock para REMOVER os clientes que falharam
     if (!to_remove.empty()) {
-        std::lock_guard<std::mutex> lg(list_mutex_);
-        for (int fd : to_remove) {
-            sessions_.erase(fd);
-            TSLOG(INFO, "Removendo cliente desconectado (socket " + std::to_string(fd) + ")");
+        std::vector<uint64_t> removed;
+        {
+            std::lock_guard<std::mutex> lg(list_mutex_);
+            for (const auto &sess : to_remove) {
+                // O fd pode já pertencer a uma nova sessão: só remove se for a mesma
+                auto it = sessions_.find(sess->getSocket());
+                if (it == sessions_.end() || it->second != sess) continue;
+                sessions_.erase(it);
+                MemoryStats::sub(MemoryCategory::REGISTRY, SESSION_NODE_BYTES);
+                TSLOGF(INFO, "Removendo cliente desconectado (socket {})", sess->getSocket());
+                removed.push_back(sess->getSessionId());
+            }
+        }
+        // removeClient() encontra o mapa sem a sessão e não repete isto
+        for (uint64_t session_id : removed) {
+            onSessionRemoved(session_id);
         }
     }
 }
 
+void ClientManager::configureFanout(size_t num_workers, size_t threshold, size_t chunk_size) {
+    fanout_pool_.reset(new FanoutPool(num_workers));
+    fanout_threshold_ = threshold;
+    fanout_chunk_size_ = chunk_size > 0 ? chunk_size : 1;
+    TSLOG(INFO, "Fanout paralelo a partir de " + std::to_string(threshold) + " destinatários (pedaços de " + std::to_string(fanout_chunk_size_) + ").");
+}
+
 std::string ClientManager::getUsername(int socket_fd) {
     std::lock_guard<std::mutex> lock(list_mutex_);
     auto it = sessions_.find(socket_fd);
@@ -92,4 +185,33 @@ std::string ClientManager::getUsername(int socket_fd) {
         return it->second->getUsername(); 
     }
     return "UNKNOWN";
-}
\ No newline at end of file
+}
+std::string ClientManager::getMemoryReport() {
+    size_t connections = getActiveCount();
+    MemoryStats::set(MemoryCategory::LOGGER,
+                     static_cast<int64_t>(ThreadSafeLogger::getInstance().getMemoryUsage()));
+
+    // Média por conexão; sem conexões mostra só o total
+    auto line = [connections](const std::string& label, int64_t bytes) {
+        std::string text = "*** " + label + ": " + MemoryStats::formatBytes(static_cast<double>(bytes));
+        if (connections > 0) {
+            text += " (" + MemoryStats::formatBytes(static_cast<double>(bytes) / connections) + "/conexão)";
+        }
+        return text + "\n";
+    };
+
+    std::string report = "*** Conexões: " + std::to_string(connections) + "\n";
+    report += line("Heap estimado", MemoryStats::getHeapTotal());
+    for (int i = 0; i < static_cast<int>(MemoryCategory::COUNT); ++i) {
+        MemoryCategory category = static_cast<MemoryCategory>(i);
+        if (category == MemoryCategory::THREAD_STACKS) continue;
+        report += line(std::string("  ") + MemoryStats::getName(category), MemoryStats::get(category));
+    }
+    report += line("Pilhas de threads (virtual)", MemoryStats::get(MemoryCategory::THREAD_STACKS));
+    size_t limit = MemoryStats::getLimit();
+    report += "*** Limite de memória: " +
+              (limit > 0 ? MemoryStats::formatBytes(static_cast<double>(limit)) : std::string("sem limite")) + "\n";
+    report += "*** Conexões recusadas: " + std::to_string(MemoryStats::getRejectedConnections()) +
+              ", mensagens descartadas: " + std::to_string(MemoryStats::getShedMessages()) + "\n";
+    return report;
+}
@@ -5,10 +5,16 @@
 #include <mutex>
 #include <memory>
 #include <string>
+#include <vector>
 #include <iostream>
+#include "FanoutPool.h"
+#include "OutboundQueue.h"
+#include "PresenceService.h"
 
 // Forward declaration da ClientSession para evitar dependência circular
 class ClientSession; 
+class FederationManager;
+class TrafficCapture;
 
 // Estrutura para manter o estado do cliente
 struct ClientInfo {
@@ -23,6 +29,30 @@ private:
     std::map<int, std::shared_ptr<ClientSession>> sessions_; //
     std::mutex list_mutex_;
 
+    // Federação (opcional): recebe as mensagens originadas localmente
+    std::weak_ptr<FederationManager> federation_;
+
+    // Captura de tráfego (opcional): entradas, saídas e mensagens recebidas
+    std::shared_ptr<TrafficCapture> capture_;
+
+    // Fanout paralelo (opcional): abaixo do limiar o envio continua na thread chamadora
+    std::unique_ptr<FanoutPool> fanout_pool_;
+    size_t fanout_threshold_ = 0;
+    size_t fanout_chunk_size_ = 0;
+
+    // Lista de presença: snapshot na entrada e deltas agregados (substitui os
+    // avisos de entrada/saída enviados um a um)
+    PresenceService presence_;
+
+    // Envia a mensagem já formatada para as sessões copiadas e remove as que falharem
+    void sendAndPrune(const std::vector<std::shared_ptr<ClientSession>>& sessions_copy,
+                      const std::string& formatted_message,
+                      MessagePriority priority,
+                      const std::string& sender);
+
+    // Registra a saída (captura e presença) de uma sessão já tirada do mapa
+    void onSessionRemoved(uint64_t session_id);
+
 public:
     // Adiciona um novo cliente à lista
     void addClient(std::shared_ptr<ClientSession> session);
@@ -32,7 +62,29 @@ public:
 
     // Envia uma mensagem de broadcast para todos os clientes, exceto o remetente
     void broadcastMessage(int sender_fd, const std::string& message);
+
+    // Entrega localmente uma mensagem vinda de outro nó (não é repassada de volta)
+    void deliverRemote(const std::string& sender_name, const std::string& message);
+
+    // Liga o gerenciador à federação; chamar antes de aceitar clientes
+    void setFederation(std::shared_ptr<FederationManager> federation) { federation_ = federation; }
+
+    // Grava uma linha recebida de um cliente (chat ou comando), se houver captura
+    void recordInbound(uint64_t session_id, const std::string& line);
+
+    // Passa a gravar o tráfego de entrada; chamar antes de aceitar clientes
+    void setCapture(std::shared_ptr<TrafficCapture> capture) { capture_ = capture; }
+
+    // Liga o fanout paralelo para broadcasts com pelo menos `threshold` destinatários,
+    // divididos em pedaços de `chunk_size`; chamar antes de aceitar clientes
+    void configureFanout(size_t num_workers, size_t threshold, size_t chunk_size);
     
+    PresenceService& getPresence() { return presence_; }
+
+    // Relatório de memória (/stats): total e média por conexão de cada subsistema,
+    // uma linha "*** ..." por item
+    std::string getMemoryReport();
+
     // Retorna o nome de usuário associado a um socket
     std::string getUsername(int socket_fd);
     
@@ -1,14 +1,19 @@
 #include "ClientSession.h"
 #include "ClientManager.h"
+#include "MessageHistory.h"
+#include "MemoryStats.h"
 #include "../libtslog/tslog.h"
 
-#include <sys/socket.h>   // send()
+#include <sys/socket.h>   // send(), getsockname()
+#include <sys/un.h>       // sockaddr_un
 #include <unistd.h>       // close()
 #include <cerrno>         // errno
 #include <cstring>        // strerror()
+#include <cctype>         // isalnum()
 #include <chrono>
 #include <thread>
 #include <string>
+#include <sstream>
 
 // se não existir MSG_NOSIGNAL, define depois dos includes
 #ifndef MSG_NOSIGNAL
@@ -17,22 +22,48 @@
 
 
 #define BUFFER_SIZE 1024
+// Maior linha recebida; além disso o trecho é tratado como uma mensagem
+#define MAX_LINE_SIZE (64 * 1024)
+// Máximo de bytes juntados num único send() pela thread de escrita. Pequeno o
+// bastante para que uma mensagem de controle não espere atrás de muito chat.
+#define WRITE_BATCH_SIZE 16384
+// Mensagens enviadas por "/history" sem N
+#define HISTORY_DEFAULT_REPLAY 20
+// Teto do sono do consumidor do anel: o produtor acorda antes, isto só cobre um
+// cliente que não avisa
+#define SHM_IDLE_WAIT_MS 100
+
+static std::atomic<uint64_t> next_session_id(1);
 
 // Construtor
 ClientSession::ClientSession(int socket_fd, 
                              std::shared_ptr<ClientManager> manager,
-                             std::shared_ptr<MessageHistory> history) 
+                             std::shared_ptr<MessageHistory> history,
+                             size_t max_backlog_bytes) 
     : client_socket_fd_(socket_fd), 
+      session_id_(next_session_id++),
+      username_("Cliente_" + std::to_string(socket_fd)),
+      outbound_(max_backlog_bytes),
       manager_(manager),
       history_(history) 
 {
-    TSLOG(DEBUG, "Sessão criada para o socket " + std::to_string(client_socket_fd_));
+    // Objeto + bloco de controle do make_shared + nome fora do SSO
+    accounted_session_bytes_ = static_cast<int64_t>(sizeof(ClientSession) + 2 * sizeof(void*)) +
+                               MemoryStats::estimate(username_) - static_cast<int64_t>(sizeof(std::string));
+    MemoryStats::add(MemoryCategory::SESSIONS, accounted_session_bytes_);
+    TSLOGF(DEBUG, "Sessão criada para o socket {}", client_socket_fd_);
     // Coloque aqui o restante do corpo do construtor
 }
 
 // Inicia a thread de trabalho, executando o método run().
 void ClientSession::start() {
-    worker_thread_ = std::thread(&ClientSession::run, this);
+    // A thread guarda uma referência: a sessão sai do ClientManager antes de run() terminar
+    auto self = shared_from_this();
+    int64_t stacks = 2 * static_cast<int64_t>(MemoryStats::getThreadStackSize());
+    accounted_stack_bytes_ += stacks;
+    MemoryStats::add(MemoryCategory::THREAD_STACKS, stacks);
+    writer_thread_ = std::thread([self] { self->writerLoop(); });
+    worker_thread_ = std::thread([self] { self->run(); });
 }
 
 // O loop principal da thread de trabalho. 
@@ -40,43 +71,306 @@ void ClientSession::run() {
     char buffer[BUFFER_SIZE];
     int bytes_read;
 
-    TSLOG(INFO, "Thread de sessão " + username_ + " iniciada.");
+    TSLOGF(INFO, "Thread de sessão {} iniciada.", getUsername());
 
+    // Um read() pode trazer várias linhas (clientes que agrupam envios) ou só parte de uma
+    std::string pending;
     while ((bytes_read = read(client_socket_fd_, buffer, BUFFER_SIZE - 1)) > 0) {
-        
-        buffer[bytes_read] = '\0';
-        std::string message(buffer);
-        
-        // Limpeza básica: remove o '\n' ou '\r'
-        while (!message.empty() && (message.back() == '\n' || message.back() == '\r')) {
-            message.pop_back();
-        }
-
-        if (message.empty()) continue;
+        pending.append(buffer, bytes_read);
 
-        TSLOG(DEBUG, "Mensagem recebida de " + username_ + ": " + message);
+        size_t start = 0, eol;
+        while ((eol = pending.find('\n', start)) != std::string::npos) {
+            handleLine(pending.substr(start, eol - start));
+            start = eol + 1;
+        }
+        pending.erase(0, start);
 
-        // Retransmite a mensagem (Broadcast)
-        manager_->broadcastMessage(client_socket_fd_, message);
+        // Linha sem fim: entrega o que já chegou em vez de acumular sem limite
+        if (pending.size() > MAX_LINE_SIZE) {
+            handleLine(pending);
+            pending.clear();
+        }
+    }
+    // Última linha sem '\n' antes do fim da conexão
+    if (!pending.empty()) {
+        handleLine(pending);
     }
     
     // Se o loop terminou (desconexão ou erro)
     if (bytes_read == 0) {
-        TSLOG(INFO, username_ + " (socket " + std::to_string(client_socket_fd_) + ") desconectou.");
+        TSLOGF(INFO, "{} (socket {}) desconectou.", getUsername(), client_socket_fd_);
     } else { 
         TSLOG(ERROR, "Erro de leitura no socket " + std::to_string(client_socket_fd_));
     }
     
+    // O anel é drenado antes de liberar a sessão
+    socket_closed_ = true;
+    if (shm_ring_) {
+        shm_ring_->wakeConsumer();
+    }
+    if (shm_thread_.joinable()) {
+        shm_thread_.join();
+    }
+
     // Liberação de recursos:
     manager_->removeClient(client_socket_fd_); 
+
+    // A thread de escrita entrega o que já estava na fila e termina
+    outbound_.close();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
     close(client_socket_fd_); 
     
-    TSLOG(INFO, "Thread de sessão " + username_ + " finalizada.");
+    TSLOGF(INFO, "Thread de sessão {} finalizada.", getUsername());
+}
+
+void ClientSession::handleLine(std::string message) {
+    // Limpeza básica: remove o '\r' de clientes que enviam "\r\n"
+    while (!message.empty() && message.back() == '\r') {
+        message.pop_back();
+    }
+
+    if (message.empty()) return;
+
+    // Captura: toda linha de entrada, inclusive comandos, para o replay reproduzir a carga real
+    manager_->recordInbound(session_id_, message);
+
+    // Heartbeat: responde pela faixa de controle, na frente do chat enfileirado
+    if (message == "/ping") {
+        sendMessage("PONG\n", MessagePriority::CONTROL);
+        return;
+    }
+
+    // Presença: troca de nome e pedido de ressincronização da lista
+    if (message.compare(0, 6, "/nick ") == 0) {
+        changeNick(message.substr(6));
+        return;
+    }
+    if (message == "/roster") {
+        manager_->getPresence().requestSnapshot(session_id_);
+        return;
+    }
+
+    // Memória estimada do servidor, por subsistema e por conexão
+    if (message == "/stats") {
+        sendMessage(manager_->getMemoryReport(), MessagePriority::CONTROL);
+        return;
+    }
+
+    // Replay do histórico num único quadro (comprimido se o cliente negociou)
+    if (message.compare(0, 6, "/caps ") == 0) {
+        negotiateCaps(message.substr(6));
+        return;
+    }
+    if (message == "/history" || message.compare(0, 9, "/history ") == 0) {
+        size_t n = HISTORY_DEFAULT_REPLAY;
+        if (message.size() > 9) {
+            try {
+                n = std::stoul(message.substr(9));
+            } catch (const std::exception&) {
+                sendMessage("*** Uso: /history [N]\n", MessagePriority::CONTROL);
+                return;
+            }
+        }
+        // O quadro pode passar do limite de chat por cliente (100 linhas de até 64 KiB),
+        // então vai pela faixa de controle, que não descarta. Para não acumular quadros
+        // sem limite, um cliente que ainda não leu o anterior recebe só um aviso.
+        if (outbound_.getControlBytes() > WRITE_BATCH_SIZE) {
+            sendMessage("*** /history recusado: a resposta anterior ainda não foi lida\n", MessagePriority::CONTROL);
+            return;
+        }
+        if (MemoryStats::isOverLimit()) {
+            MemoryStats::countShedMessage();
+            sendMessage("*** /history recusado: servidor sem memória, tente mais tarde\n", MessagePriority::CONTROL);
+            return;
+        }
+        sendMessage(history_->getLastNFrame(n, compress_history_), MessagePriority::CONTROL);
+        return;
+    }
+
+    // Negociação do transporte em memória compartilhada (só para clientes locais)
+    if (message.compare(0, 5, "/shm ") == 0) {
+        attachSharedMemory(message.substr(5));
+        return;
+    }
+
+    handleMessage(message);
+}
+
+// "/caps lz ..." -> "@caps lz": responde só com o que o servidor aceitou
+void ClientSession::negotiateCaps(const std::string& caps) {
+    std::istringstream in(caps);
+    std::string cap, accepted;
+    while (in >> cap) {
+        if (cap == "lz") {
+            compress_history_ = true;
+            accepted += " lz";
+        }
+    }
+    sendMessage("@caps" + accepted + "\n", MessagePriority::CONTROL);
+}
+
+void ClientSession::handleMessage(const std::string& message) {
+    std::string username = getUsername();
+    TSLOGF(DEBUG, "Mensagem recebida de {}: {}", username, message);
+
+    // Guarda no histórico (também é o que a federação injeta nos outros nós)
+    history_->addMessage(username, message);
+
+    // Retransmite a mensagem (Broadcast)
+    manager_->broadcastMessage(client_socket_fd_, message);
 }
 
-// Envia toda a mensagem com tratamento de partial writes.
+// Nomes curtos, sem espaços nem os separadores usados na lista de presença
+// "cliente_" (sem diferenciar maiúsculas) seguido só de dígitos
+static bool isDefaultName(const std::string& name) {
+    static const std::string prefix = "cliente_";
+    if (name.size() <= prefix.size()) return false;
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        if (tolower(static_cast<unsigned char>(name[i])) != prefix[i]) return false;
+    }
+    for (size_t i = prefix.size(); i < name.size(); ++i) {
+        if (!isdigit(static_cast<unsigned char>(name[i]))) return false;
+    }
+    return true;
+}
+
+void ClientSession::changeNick(const std::string& name) {
+    bool valid = !name.empty() && name.size() <= 32;
+    for (char c : name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-' && c != '.') valid = false;
+    }
+    if (!valid) {
+        sendMessage("*** Nome inválido (até 32 letras, números, '_', '-' ou '.')\n", MessagePriority::CONTROL);
+        return;
+    }
+    // "Cliente_<n>" é o nome padrão de quem entrar no socket n: tomá-lo faria o
+    // próximo cliente entrar com um nome repetido. Só o próprio padrão pode voltar.
+    if (isDefaultName(name) && name != "Cliente_" + std::to_string(client_socket_fd_)) {
+        sendMessage("*** Nome " + name + " é reservado\n", MessagePriority::CONTROL);
+        return;
+    }
+    if (!manager_->getPresence().rename(session_id_, name)) {
+        sendMessage("*** Nome " + name + " já está em uso\n", MessagePriority::CONTROL);
+        return;
+    }
+
+    std::string old_name;
+    {
+        std::lock_guard<std::mutex> lock(username_mutex_);
+        old_name = username_;
+        username_ = name;
+        int64_t delta = MemoryStats::estimate(username_) - MemoryStats::estimate(old_name);
+        accounted_session_bytes_ += delta;
+        MemoryStats::add(MemoryCategory::SESSIONS, delta);
+    }
+    TSLOG(INFO, old_name + " agora é " + name);
+}
+
+void ClientSession::attachSharedMemory(const std::string& name) {
+    struct sockaddr_un local;
+    socklen_t len = sizeof(local);
+    if (getsockname(client_socket_fd_, (struct sockaddr*)&local, &len) < 0 || local.sun_family != AF_UNIX) {
+        TSLOG(WARNING, "Pedido /shm recusado: socket " + std::to_string(client_socket_fd_) + " não é local.");
+        sendMessage("@shm refused\n", MessagePriority::CONTROL);
+        return;
+    }
+    if (shm_ring_) {
+        TSLOG(WARNING, "Pedido /shm repetido no socket " + std::to_string(client_socket_fd_));
+        sendMessage("@shm refused\n", MessagePriority::CONTROL);
+        return;
+    }
+
+    try {
+        shm_ring_ = ShmRing::open(name);
+    } catch (const std::exception& e) {
+        TSLOG(ERROR, "Falha ao anexar anel " + name + ": " + e.what());
+        sendMessage("@shm refused\n", MessagePriority::CONTROL);
+        return;
+    }
+    accounted_ring_bytes_ = static_cast<int64_t>(shm_ring_->getCapacity());
+    MemoryStats::add(MemoryCategory::BUFFERS, accounted_ring_bytes_);
+    int64_t stack = static_cast<int64_t>(MemoryStats::getThreadStackSize());
+    accounted_stack_bytes_ += stack;
+    MemoryStats::add(MemoryCategory::THREAD_STACKS, stack);
+    shm_thread_ = std::thread(&ClientSession::shmLoop, this);
+    // O cliente só passa a escrever no anel depois desta confirmação
+    sendMessage("@shm ok\n", MessagePriority::CONTROL);
+    TSLOG(INFO, getUsername() + " usando memória compartilhada (" + name + ")");
+}
+
+// Uma mensagem do anel passa pelo mesmo caminho das linhas do socket (comandos,
+// filtro de linhas vazias, captura); várias linhas viram várias mensagens
+void ClientSession::handleRingMessage(const std::string& message) {
+    size_t start = 0, eol;
+    while ((eol = message.find('\n', start)) != std::string::npos) {
+        handleLine(message.substr(start, eol - start));
+        start = eol + 1;
+    }
+    handleLine(message.substr(start));
+}
+
+// Consome o anel: espera ativa curta, depois yield, depois dorme no futex do anel
+void ClientSession::shmLoop() {
+    std::string message;
+    unsigned idle = 0;
+
+    while (true) {
+        if (shm_ring_->pop(message)) {
+            idle = 0;
+            handleRingMessage(message);
+            continue;
+        }
+        if (shm_ring_->isClosed() || socket_closed_) {
+            // Tudo o que foi escrito antes do fechamento já está visível
+            while (shm_ring_->pop(message)) {
+                handleRingMessage(message);
+            }
+            break;
+        }
+        ++idle;
+        if (idle < 64) {
+            continue;
+        } else if (idle < 256) {
+            std::this_thread::yield();
+        } else {
+            shm_ring_->waitForData(std::chrono::milliseconds(SHM_IDLE_WAIT_MS));
+        }
+    }
+}
+
+bool ClientSession::sendMessage(const std::string &msg, MessagePriority priority, const std::string& sender) {
+    return outbound_.push(msg, priority, sender);
+}
+
+// Thread de escrita: cada lote é um único send(); falha derruba a conexão
+void ClientSession::writerLoop() {
+    std::string batch;
+    int64_t accounted = 0; // capacidade do buffer de escrita, que fica com a sessão
+    while (outbound_.popBatch(batch, WRITE_BATCH_SIZE)) {
+        int64_t capacity = static_cast<int64_t>(batch.capacity());
+        if (capacity != accounted) {
+            MemoryStats::add(MemoryCategory::BUFFERS, capacity - accounted);
+            accounted = capacity;
+        }
+        if (!writeAll(batch)) {
+            // Acorda o run() (read retorna 0/erro), que remove a sessão do gerenciador
+            outbound_.close();
+            ::shutdown(client_socket_fd_, SHUT_RDWR);
+            break;
+        }
+    }
+    MemoryStats::sub(MemoryCategory::BUFFERS, accounted);
+    size_t dropped = outbound_.getDroppedCount();
+    if (dropped > 0) {
+        TSLOGF(WARNING, "{} mensagens descartadas para o cliente lento {}", dropped, getUsername());
+    }
+}
+
+// Envia todos os bytes com tratamento de partial writes.
 // Retorna true se todos os bytes foram enviados, false em erro/cliente fechado.
-bool ClientSession::sendMessage(const std::string &msg) {
+bool ClientSession::writeAll(const std::string &msg) {
     const char *buf = msg.data();
     size_t total = msg.size();
     size_t sent = 0;
@@ -94,7 +388,7 @@ bool ClientSession::sendMessage(const std::string &msg) {
         }
         if (n == 0) {
             // socket fechado
-            TSLOG(DEBUG, "send() retornou 0 para socket " + std::to_string(client_socket_fd_));
+            TSLOGF(DEBUG, "send() retornou 0 para socket {}", client_socket_fd_);
             return false;
         }
         // n < 0 -> erro
@@ -106,7 +400,7 @@ bool ClientSession::sendMessage(const std::string &msg) {
         }
         // Erros como EPIPE e ECONNRESET indicam que o cliente desconectou
         if (errno == EPIPE || errno == ECONNRESET) {
-            TSLOG(INFO, "Cliente desconectado (send failed) no socket " + std::to_string(client_socket_fd_) + ": " + std::strerror(errno));
+            TSLOGF(INFO, "Cliente desconectado (send failed) no socket {}: {}", client_socket_fd_, std::strerror(errno));
             return false;
         }
 
@@ -123,5 +417,11 @@ ClientSession::~ClientSession() {
     if (worker_thread_.joinable()) {
         worker_thread_.detach(); // Uso de detach para evitar deadlocks no destrutor
     }
-    TSLOG(DEBUG, "ClientSession destruída para o socket " + std::to_string(client_socket_fd_));
+    if (writer_thread_.joinable()) {
+        writer_thread_.detach();
+    }
+    MemoryStats::sub(MemoryCategory::SESSIONS, accounted_session_bytes_);
+    MemoryStats::sub(MemoryCategory::THREAD_STACKS, accounted_stack_bytes_);
+    MemoryStats::sub(MemoryCategory::BUFFERS, accounted_ring_bytes_);
+    TSLOGF(DEBUG, "ClientSession destruída para o socket {}", client_socket_fd_);
 }
\ No newline at end of file
@@ -4,7 +4,12 @@
 #include <thread> // NECESSÁRIO
 #include <string>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
 #include "../libtslog/tslog.h" 
+#include "ShmRing.h"
+#include "OutboundQueue.h"
 
 class ClientManager; // Forward declaration
 class MessageHistory;
@@ -12,24 +17,65 @@ class MessageHistory;
 class ClientSession : public std::enable_shared_from_this<ClientSession> {
 private:
     int client_socket_fd_ = -1; // <--- CORREÇÃO 1
+    uint64_t session_id_;       // único no processo (o fd é reutilizado pelo kernel)
     std::string username_;      // <--- CORREÇÃO 1
+    mutable std::mutex username_mutex_; // /nick troca o nome enquanto outras threads leem
     std::thread worker_thread_; 
+
+    // Saída: a thread de escrita esvazia a fila com prioridades (CONTROL antes de BULK)
+    OutboundQueue outbound_;
+    std::thread writer_thread_;
     
     std::shared_ptr<ClientManager> manager_; 
     std::shared_ptr<MessageHistory> history_; 
 
+    // Transporte local opcional (clientes AF_UNIX): mensagens chegam pelo anel
+    std::unique_ptr<ShmRing> shm_ring_;
+    std::thread shm_thread_;
+    std::atomic<bool> socket_closed_{false};
+
+    // Cliente negociou "/caps lz": o replay do histórico vai comprimido
+    std::atomic<bool> compress_history_{false};
+
+    // O que esta sessão lançou na contabilidade de memória (devolvido no destrutor)
+    int64_t accounted_session_bytes_ = 0;
+    std::atomic<int64_t> accounted_stack_bytes_{0};
+    int64_t accounted_ring_bytes_ = 0;
+
     void run(); 
+    void writerLoop();
+    bool writeAll(const std::string& data);
+    void handleLine(std::string message);
+    void negotiateCaps(const std::string& caps);
+    void handleMessage(const std::string& message);
+    void changeNick(const std::string& name);
+    void attachSharedMemory(const std::string& name);
+    void handleRingMessage(const std::string& message);
+    void shmLoop();
 
 public:
     // <--- CORREÇÃO 3: DECLARAÇÃO DO CONSTRUTOR
-    ClientSession(int socket_fd, std::shared_ptr<ClientManager> manager, std::shared_ptr<MessageHistory> history);
+    // Bytes de chat (BULK) que podem ficar enfileirados para um cliente lento
+    static const size_t DEFAULT_MAX_BACKLOG = 4 * 1024 * 1024;
+
+    ClientSession(int socket_fd, std::shared_ptr<ClientManager> manager, std::shared_ptr<MessageHistory> history,
+                  size_t max_backlog_bytes = DEFAULT_MAX_BACKLOG);
 
     void start();
-    bool sendMessage(const std::string& message);
+
+    // Enfileira a mensagem para a thread de escrita. sender identifica a fila
+    // BULK do remetente (divisão justa). Retorna false se a sessão já encerrou.
+    bool sendMessage(const std::string& message,
+                     MessagePriority priority = MessagePriority::BULK,
+                     const std::string& sender = std::string());
     
     // Getters
     int getSocket() const { return client_socket_fd_; } 
-    std::string getUsername() const { return username_; }
+    uint64_t getSessionId() const { return session_id_; }
+    std::string getUsername() const {
+        std::lock_guard<std::mutex> lock(username_mutex_);
+        return username_;
+    }
 
     ~ClientSession();
 };
@@ -0,0 +1,103 @@
+#include "FanoutPool.h"
+#include "../libtslog/tslog.h"
+
+FanoutPool::FanoutPool(size_t num_workers) {
+    if (num_workers == 0) num_workers = 1;
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (size_t i = 0; i < num_workers; ++i) {
+        threads_.emplace_back(&FanoutPool::workerLoop, this, i);
+    }
+    TSLOG(INFO, "Pool de fanout iniciado com " + std::to_string(num_workers) + " workers.");
+}
+
+void FanoutPool::runAll(std::vector<Task> tasks) {
+    if (tasks.empty()) return;
+
+    // Contador de conclusão do lote (a thread chamadora espera nele)
+    struct Latch {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t remaining;
+    };
+    auto latch = std::make_shared<Latch>();
+    latch->remaining = tasks.size();
+
+    // Contabiliza antes de publicar, para que um pop nunca veja queued_ == 0
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        queued_ += tasks.size();
+    }
+
+    size_t start = next_worker_.fetch_add(1);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        Task wrapped = [task = std::move(tasks[i]), latch] {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                TSLOG(ERROR, std::string("Exceção no fanout: ") + e.what());
+            }
+            std::lock_guard<std::mutex> lock(latch->mutex);
+            if (--latch->remaining == 0) latch->cv.notify_all();
+        };
+        Worker& w = *workers_[(start + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.tasks.push_back(std::move(wrapped));
+    }
+    wake_cv_.notify_all();
+
+    std::unique_lock<std::mutex> lock(latch->mutex);
+    latch->cv.wait(lock, [&latch] { return latch->remaining == 0; });
+}
+
+bool FanoutPool::popLocal(size_t index, Task& task) {
+    Worker& w = *workers_[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty()) return false;
+    task = std::move(w.tasks.front());
+    w.tasks.pop_front();
+    return true;
+}
+
+// Rouba pelo fundo: pega o trabalho mais distante do que a vítima faria em seguida
+bool FanoutPool::steal(size_t thief, Task& task) {
+    for (size_t k = 1; k < workers_.size(); ++k) {
+        Worker& victim = *workers_[(thief + k) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+void FanoutPool::workerLoop(size_t index) {
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                --queued_;
+            }
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) return;
+    }
+}
+
+FanoutPool::~FanoutPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+}
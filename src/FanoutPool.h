@@ -0,0 +1,56 @@
+#ifndef FANOUT_POOL_H
+#define FANOUT_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de threads para o fanout de broadcasts grandes.
+// Cada worker tem sua própria deque: consome pela frente e, quando fica sem
+// trabalho, rouba pelo fundo da deque dos outros (work stealing).
+// O fanout só enfileira (cópia + mutex da OutboundQueue de cada sessão); a
+// escrita nos sockets é das threads de escrita. O pool divide esse custo de CPU
+// entre núcleos e só compensa quando ele passa do custo de entregar as tarefas.
+class FanoutPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit FanoutPool(size_t num_workers);
+
+    FanoutPool(const FanoutPool&) = delete;
+    FanoutPool& operator=(const FanoutPool&) = delete;
+
+    // Distribui as tarefas entre os workers e bloqueia até todas terminarem
+    void runAll(std::vector<Task> tasks);
+
+    size_t getWorkerCount() const { return workers_.size(); }
+
+    ~FanoutPool();
+
+private:
+    struct Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_worker_{0}; // distribuição round-robin entre chamadas
+
+    // Acorda workers ociosos quando chegam tarefas
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    size_t queued_ = 0; // tarefas nas deques (protegido por wake_mutex_)
+    bool stop_ = false;
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+};
+
+#endif // FANOUT_POOL_H
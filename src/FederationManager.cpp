@@ -0,0 +1,258 @@
+#include "FederationManager.h"
+#include "ClientManager.h"
+#include "MemoryStats.h"
+#include "MessageHistory.h"
+
+#include <sys/socket.h>   // socket, bind, listen, accept, connect
+#include <netinet/in.h>   // sockaddr_in
+#include <arpa/inet.h>    // inet_pton
+#include <netdb.h>        // getaddrinfo
+#include <unistd.h>       // close()
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+// Intervalo entre tentativas de reconexão a um par
+#define PEER_RETRY_MS 2000
+
+FederationManager::FederationManager(const std::string& node_id,
+                                     std::shared_ptr<ClientManager> manager,
+                                     std::shared_ptr<MessageHistory> history)
+    : manager_(manager),
+      history_(history)
+{
+    auto epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    origin_id_ = node_id + "#" + std::to_string(epoch);
+    TSLOG(INFO, "Federação inicializada como " + origin_id_);
+}
+
+void FederationManager::listen(const std::string& bind_addr, int peer_port) {
+    listen_socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket_fd_ < 0) {
+        TSLOG(ERROR, "Falha ao criar socket de pares.");
+        throw std::runtime_error("Falha ao criar socket de pares.");
+    }
+
+    int opt = 1;
+    if (setsockopt(listen_socket_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
+        TSLOG(WARNING, "setsockopt falhou no socket de pares.");
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(peer_port);
+    if (inet_pton(AF_INET, bind_addr.c_str(), &addr.sin_addr) <= 0) {
+        TSLOG(ERROR, "Endereço inválido para a porta de pares: " + bind_addr);
+        close(listen_socket_fd_);
+        listen_socket_fd_ = -1;
+        throw std::runtime_error("Endereço de pares inválido.");
+    }
+
+    if (bind(listen_socket_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        ::listen(listen_socket_fd_, 5) < 0) {
+        TSLOG(ERROR, "Falha ao escutar na porta de pares " + std::to_string(peer_port) + ".");
+        close(listen_socket_fd_);
+        listen_socket_fd_ = -1;
+        throw std::runtime_error("Falha ao escutar na porta de pares.");
+    }
+
+    TSLOG(INFO, "Federação escutando pares em " + bind_addr + ":" + std::to_string(peer_port));
+    acceptor_thread_ = std::thread(&FederationManager::acceptLoop, this);
+}
+
+void FederationManager::acceptLoop() {
+    while (running_) {
+        int fd = accept(listen_socket_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (!running_) break;
+            TSLOG(ERROR, "Erro ao aceitar conexão de par.");
+            continue;
+        }
+        TSLOG(INFO, "Conexão de par aceita no socket " + std::to_string(fd));
+        attach(fd, false);
+    }
+}
+
+void FederationManager::connectTo(const std::string& host, int port) {
+    connector_threads_.emplace_back(&FederationManager::connectLoop, this, host, port);
+}
+
+// Mantém o link de saída: conecta, espera cair, e tenta de novo
+void FederationManager::connectLoop(std::string host, int port) {
+    while (running_) {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* res = nullptr;
+
+        int fd = -1;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) == 0) {
+            for (struct addrinfo* ai = res; ai != nullptr && fd < 0; ai = ai->ai_next) {
+                fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+                if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            freeaddrinfo(res);
+        }
+
+        if (fd >= 0) {
+            TSLOG(INFO, "Conectado ao par " + host + ":" + std::to_string(port));
+            auto link = attach(fd, true);
+            link->waitClosed();
+
+            // Fechado por ser duplicado: o link aceito do mesmo nó segue ativo, só
+            // redisca quando ele cair
+            if (link->isDuplicate()) {
+                std::string remote = link->getRemoteNode();
+                while (running_ && hasLinkTo(remote)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+        }
+
+        // Espera antes de reconectar, sem atrasar o stop()
+        for (int waited = 0; running_ && waited < PEER_RETRY_MS; waited += 100) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+std::shared_ptr<PeerLink> FederationManager::attach(int socket_fd, bool outbound) {
+    std::weak_ptr<FederationManager> weak = shared_from_this();
+    auto link = std::make_shared<PeerLink>(
+        socket_fd, origin_id_, outbound,
+        [weak](const PeerRecord& record) {
+            if (auto self = weak.lock()) self->onRecord(record);
+        },
+        [weak](std::shared_ptr<PeerLink> closed) {
+            if (auto self = weak.lock()) self->onLinkClosed(closed);
+        },
+        [weak](std::shared_ptr<PeerLink> identified) {
+            if (auto self = weak.lock()) self->onHello(identified);
+        });
+
+    {
+        std::lock_guard<std::mutex> lock(links_mutex_);
+        links_.push_back(link);
+    }
+    link->start();
+    if (!running_) link->close(); // stop() já copiou a lista de links
+    return link;
+}
+
+// Dois nós que se discam mutuamente ficam com dois links; cada mensagem iria pelos
+// dois. Os dois lados escolhem o mesmo: fica o link discado pelo nó de menor id.
+void FederationManager::onHello(std::shared_ptr<PeerLink> link) {
+    std::string remote = link->getRemoteNode();
+    std::shared_ptr<PeerLink> loser;
+    {
+        std::lock_guard<std::mutex> lock(links_mutex_);
+        for (auto& other : links_) {
+            if (other == link || !other->isOpen() || other->getRemoteNode() != remote) continue;
+            if (other->isOutbound() == link->isOutbound()) {
+                // Mesmo sentido (--peer repetido): fica o de menor socket, visto igual pelas duas threads
+                loser = link->getSocket() > other->getSocket() ? link : other;
+            } else {
+                bool keep_outbound = origin_id_ < remote;
+                loser = link->isOutbound() == keep_outbound ? other : link;
+            }
+            break;
+        }
+    }
+    if (loser) {
+        TSLOG(INFO, "Link duplicado para " + remote + " fechado (socket " + std::to_string(loser->getSocket()) + ")");
+        loser->closeAsDuplicate();
+    }
+}
+
+bool FederationManager::hasLinkTo(const std::string& remote_node) {
+    std::lock_guard<std::mutex> lock(links_mutex_);
+    for (auto& link : links_) {
+        if (link->isOpen() && link->getRemoteNode() == remote_node) return true;
+    }
+    return false;
+}
+
+void FederationManager::publish(const std::string& sender, const std::string& message) {
+    PeerRecord record;
+    record.origin = origin_id_;
+    record.seq = next_seq_++;
+    record.sender = sender;
+    record.message = message;
+
+    std::lock_guard<std::mutex> lock(links_mutex_);
+    for (auto& link : links_) {
+        link->enqueue(record);
+    }
+}
+
+void FederationManager::onRecord(const PeerRecord& record) {
+    if (record.origin == origin_id_) return; // eco de nós próprios
+
+    {
+        // Uma reconexão (ou o instante antes de fechar um link duplicado) pode repetir registros
+        std::lock_guard<std::mutex> lock(dedup_mutex_);
+        auto inserted = last_seq_.insert(std::make_pair(record.origin, uint64_t(0)));
+        if (inserted.second) {
+            MemoryStats::add(MemoryCategory::FEDERATION, MemoryStats::MAP_NODE_OVERHEAD +
+                                 MemoryStats::estimate(record.origin) + sizeof(uint64_t));
+        }
+        uint64_t& last = inserted.first->second;
+        if (record.seq <= last) return;
+        last = record.seq;
+    }
+
+    // Os nomes padrão (Cliente_<n>) se repetem entre nós: o remetente remoto leva o
+    // nó de origem (sem a época), como "Cliente_5@node-a"
+    std::string sender = record.sender + "@" + record.origin.substr(0, record.origin.rfind('#'));
+    history_->addMessage(sender, record.message);
+    manager_->deliverRemote(sender, record.message);
+}
+
+void FederationManager::onLinkClosed(std::shared_ptr<PeerLink> link) {
+    std::lock_guard<std::mutex> lock(links_mutex_);
+    links_.erase(std::remove(links_.begin(), links_.end(), link), links_.end());
+}
+
+size_t FederationManager::getLinkCount() {
+    std::lock_guard<std::mutex> lock(links_mutex_);
+    return links_.size();
+}
+
+void FederationManager::stop() {
+    if (!running_.exchange(false)) return;
+
+    if (listen_socket_fd_ >= 0) {
+        ::shutdown(listen_socket_fd_, SHUT_RDWR); // desbloqueia o accept()
+        close(listen_socket_fd_);
+        listen_socket_fd_ = -1;
+    }
+
+    std::vector<std::shared_ptr<PeerLink>> links_copy;
+    {
+        std::lock_guard<std::mutex> lock(links_mutex_);
+        links_copy = links_;
+    }
+    for (auto& link : links_copy) link->close();
+
+    if (acceptor_thread_.joinable()) acceptor_thread_.join();
+    for (auto& t : connector_threads_) {
+        if (t.joinable()) t.join();
+    }
+    TSLOG(INFO, "Federação encerrada.");
+}
+
+FederationManager::~FederationManager() {
+    stop();
+    std::lock_guard<std::mutex> lock(dedup_mutex_);
+    for (const auto& entry : last_seq_) {
+        MemoryStats::sub(MemoryCategory::FEDERATION, MemoryStats::MAP_NODE_OVERHEAD +
+                             MemoryStats::estimate(entry.first) + sizeof(uint64_t));
+    }
+}
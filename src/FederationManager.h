@@ -0,0 +1,70 @@
+#ifndef FEDERATION_MANAGER_H
+#define FEDERATION_MANAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PeerLink.h"
+#include "../libtslog/tslog.h"
+
+class ClientManager;
+class MessageHistory;
+
+// Federação de servidores: cada nó repassa as mensagens originadas localmente
+// para os pares, e injeta as recebidas no fanout e no histórico locais.
+// As mensagens não são retransmitidas: todos os nós precisam de um link com
+// todos os outros (malha completa). Há no máximo um link por par de nós.
+class FederationManager : public std::enable_shared_from_this<FederationManager> {
+private:
+    std::string origin_id_; // node_id#epoch: um reinício do nó zera as sequências
+    std::atomic<uint64_t> next_seq_{1};
+    std::atomic<bool> running_{true};
+
+    std::shared_ptr<ClientManager> manager_;
+    std::shared_ptr<MessageHistory> history_;
+
+    std::vector<std::shared_ptr<PeerLink>> links_;
+    std::mutex links_mutex_;
+
+    // Maior sequência já entregue por origem (de-duplicação)
+    std::map<std::string, uint64_t> last_seq_;
+    std::mutex dedup_mutex_;
+
+    int listen_socket_fd_ = -1;
+    std::thread acceptor_thread_;
+    std::vector<std::thread> connector_threads_;
+
+    void acceptLoop();
+    void connectLoop(std::string host, int port);
+    std::shared_ptr<PeerLink> attach(int socket_fd, bool outbound);
+    void onHello(std::shared_ptr<PeerLink> link);
+    bool hasLinkTo(const std::string& remote_node);
+    void onRecord(const PeerRecord& record);
+    void onLinkClosed(std::shared_ptr<PeerLink> link);
+
+public:
+    FederationManager(const std::string& node_id,
+                      std::shared_ptr<ClientManager> manager,
+                      std::shared_ptr<MessageHistory> history);
+
+    // Escuta conexões de outros nós na porta de pares, só no endereço bind_addr
+    // (o HELLO não é autenticado: quem alcança a porta pode injetar chat)
+    void listen(const std::string& bind_addr, int peer_port);
+
+    // Mantém um link de saída com o par em host:port (reconecta se cair)
+    void connectTo(const std::string& host, int port);
+
+    // Repassa uma mensagem originada localmente para todos os pares
+    void publish(const std::string& sender, const std::string& message);
+
+    size_t getLinkCount();
+    void stop();
+    ~FederationManager();
+};
+
+#endif // FEDERATION_MANAGER_H
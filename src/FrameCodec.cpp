@@ -0,0 +1,75 @@
+#include "FrameCodec.h"
+#include "LzCodec.h"
+
+#include <sstream>
+
+std::string FrameCodec::encodeBatch(const std::vector<std::string>& lines, bool compress) {
+    std::string raw;
+    for (const auto& line : lines) {
+        raw += line;
+        raw += '\n';
+    }
+
+    size_t raw_len = raw.size();
+    int flags = 0;
+    std::string payload;
+    if (compress) {
+        std::string packed = LzCodec::compress(raw);
+        if (packed.size() < raw.size()) {
+            payload.swap(packed);
+            flags = FLAG_LZ;
+        }
+    }
+    if (flags == 0) {
+        payload.swap(raw);
+    }
+
+    std::string frame = "@batch " + std::to_string(flags) + " " + std::to_string(raw_len) + " " +
+                        std::to_string(payload.size()) + "\n";
+    frame += payload;
+    return frame;
+}
+
+bool FrameCodec::feed(const char* data, size_t length, const LineHandler& on_line) {
+    pending_.append(data, length);
+
+    size_t start = 0;
+    while (true) {
+        size_t eol = pending_.find('\n', start);
+        if (eol == std::string::npos) break;
+
+        if (pending_.compare(start, 7, "@batch ") != 0) {
+            on_line(pending_.substr(start, eol - start));
+            start = eol + 1;
+            continue;
+        }
+
+        std::istringstream header(pending_.substr(start + 7, eol - start - 7));
+        int flags = 0;
+        size_t raw_len = 0, payload_len = 0;
+        if (!(header >> flags >> raw_len >> payload_len) || (flags & ~FLAG_LZ) != 0 ||
+            raw_len > MAX_BATCH_BYTES || payload_len > MAX_BATCH_BYTES) {
+            return false;
+        }
+        if (pending_.size() - (eol + 1) < payload_len) break; // lote incompleto
+
+        std::string payload = pending_.substr(eol + 1, payload_len);
+        start = eol + 1 + payload_len;
+
+        std::string raw;
+        if (flags & FLAG_LZ) {
+            if (!LzCodec::decompress(payload, raw_len, raw)) return false;
+        } else {
+            if (payload_len != raw_len) return false;
+            raw.swap(payload);
+        }
+
+        size_t line_start = 0, line_end;
+        while ((line_end = raw.find('\n', line_start)) != std::string::npos) {
+            on_line(raw.substr(line_start, line_end - line_start));
+            line_start = line_end + 1;
+        }
+    }
+    pending_.erase(0, start);
+    return true;
+}
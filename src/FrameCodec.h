@@ -0,0 +1,34 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Quadro de lote do servidor para o cliente: várias linhas num bloco só, com
+// compressão opcional (negociada pelo cliente com "/caps lz"):
+//   @batch <flags> <tamanho_original> <tamanho_do_payload>\n<payload>
+// flags: 0 = payload em texto, 1 = payload comprimido com o LzCodec. O payload
+// descomprimido são linhas terminadas em '\n', entregues uma a uma.
+class FrameCodec {
+public:
+    static const int FLAG_LZ = 1;
+    // Maior lote aceito pelo decodificador (um tamanho maior indica fluxo corrompido)
+    static const size_t MAX_BATCH_BYTES = 16 * 1024 * 1024;
+
+    using LineHandler = std::function<void(const std::string&)>;
+
+    // Monta o quadro; só comprime se for pedido e o resultado ficar menor
+    static std::string encodeBatch(const std::vector<std::string>& lines, bool compress);
+
+    // Acrescenta bytes recebidos e entrega as linhas completas, desmontando os
+    // lotes. false se o fluxo estiver corrompido (o chamador deve desconectar).
+    bool feed(const char* data, size_t length, const LineHandler& on_line);
+
+    void reset() { pending_.clear(); }
+
+private:
+    std::string pending_;
+};
+
+#endif // FRAME_CODEC_H
@@ -0,0 +1,120 @@
+#include "LzCodec.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 65535
+
+static uint32_t read32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t hash32(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Comprimentos >= 15 continuam em bytes de 255 e terminam num byte < 255
+static void writeLength(std::string& out, size_t extra) {
+    while (extra >= 255) {
+        out.push_back(static_cast<char>(255));
+        extra -= 255;
+    }
+    out.push_back(static_cast<char>(extra));
+}
+
+static bool readLength(const std::string& in, size_t& ip, size_t& length) {
+    while (true) {
+        if (ip >= in.size()) return false;
+        unsigned char b = static_cast<unsigned char>(in[ip++]);
+        length += b;
+        if (b != 255) return true;
+    }
+}
+
+static void emitSequence(std::string& out, const char* literals, size_t lit_len,
+                         size_t offset, size_t match_len, bool has_match) {
+    size_t match_code = has_match ? match_len - LZ_MIN_MATCH : 0;
+    unsigned char token = static_cast<unsigned char>(((lit_len < 15 ? lit_len : 15) << 4) |
+                                                     (match_code < 15 ? match_code : 15));
+    out.push_back(static_cast<char>(token));
+    if (lit_len >= 15) writeLength(out, lit_len - 15);
+    out.append(literals, lit_len);
+    if (!has_match) return;
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (match_code >= 15) writeLength(out, match_code - 15);
+}
+
+std::string LzCodec::compress(const std::string& input) {
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+    const char* data = input.data();
+    size_t n = input.size();
+
+    std::vector<int32_t> table(1u << LZ_HASH_BITS, -1);
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + LZ_MIN_MATCH <= n) {
+        uint32_t h = hash32(read32(data + pos));
+        int32_t candidate = table[h];
+        table[h] = static_cast<int32_t>(pos);
+
+        if (candidate < 0 || pos - static_cast<size_t>(candidate) > LZ_MAX_OFFSET ||
+            read32(data + candidate) != read32(data + pos)) {
+            ++pos;
+            continue;
+        }
+
+        size_t length = LZ_MIN_MATCH;
+        while (pos + length < n && data[candidate + length] == data[pos + length]) {
+            ++length;
+        }
+        emitSequence(out, data + anchor, pos - anchor, pos - candidate, length, true);
+        pos += length;
+        anchor = pos;
+        // Registra a posição logo antes do fim do match: ajuda a encadear repetições
+        if (pos >= 2 && pos + 2 <= n) {
+            table[hash32(read32(data + pos - 2))] = static_cast<int32_t>(pos - 2);
+        }
+    }
+    emitSequence(out, data + anchor, n - anchor, 0, 0, false);
+    return out;
+}
+
+bool LzCodec::decompress(const std::string& input, size_t raw_len, std::string& output) {
+    output.clear();
+    output.reserve(raw_len);
+    size_t ip = 0;
+    while (ip < input.size()) {
+        unsigned char token = static_cast<unsigned char>(input[ip++]);
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !readLength(input, ip, lit_len)) return false;
+        if (lit_len > input.size() - ip || lit_len > raw_len - output.size()) return false;
+        output.append(input, ip, lit_len);
+        ip += lit_len;
+
+        if (ip == input.size()) break; // última sequência: só literais
+
+        if (input.size() - ip < 2) return false;
+        size_t offset = static_cast<unsigned char>(input[ip]) |
+                        (static_cast<size_t>(static_cast<unsigned char>(input[ip + 1])) << 8);
+        ip += 2;
+        size_t match_len = token & 0x0F;
+        if (match_len == 15 && !readLength(input, ip, match_len)) return false;
+        match_len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > output.size() || match_len > raw_len - output.size()) return false;
+
+        // Cópia byte a byte: o match pode se sobrepor ao que está sendo escrito
+        size_t from = output.size() - offset;
+        for (size_t i = 0; i < match_len; ++i) {
+            output.push_back(output[from + i]);
+        }
+    }
+    return output.size() == raw_len;
+}
@@ -0,0 +1,20 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <string>
+
+// Compressor LZ77 pequeno e sem dependências (formato no estilo do LZ4), para
+// lotes de texto muito repetitivo ("remetente: texto\n"). Sequências:
+//   token (1 byte: literais << 4 | (match - 4)), literais extras (bytes 255...),
+//   literais, offset (2 bytes little endian), match extra (bytes 255...)
+// A última sequência só tem literais. Offsets de até 64 KiB.
+class LzCodec {
+public:
+    static std::string compress(const std::string& input);
+
+    // raw_len é o tamanho original (vem no cabeçalho do quadro); false se a
+    // entrada estiver corrompida ou não produzir exatamente raw_len bytes
+    static bool decompress(const std::string& input, size_t raw_len, std::string& output);
+};
+
+#endif // LZ_CODEC_H
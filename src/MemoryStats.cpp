@@ -0,0 +1,63 @@
+#include "MemoryStats.h"
+
+#include <pthread.h>
+#include <cstdio>
+
+std::atomic<int64_t> MemoryStats::counters_[static_cast<int>(MemoryCategory::COUNT)];
+std::atomic<size_t> MemoryStats::limit_(0);
+std::atomic<uint64_t> MemoryStats::rejected_connections_(0);
+std::atomic<uint64_t> MemoryStats::shed_messages_(0);
+
+int64_t MemoryStats::getHeapTotal() {
+    int64_t total = 0;
+    for (int i = 0; i < static_cast<int>(MemoryCategory::COUNT); ++i) {
+        if (i == static_cast<int>(MemoryCategory::THREAD_STACKS)) continue;
+        total += counters_[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+const char* MemoryStats::getName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::SESSIONS: return "sessões";
+        case MemoryCategory::THREAD_STACKS: return "pilhas (reservadas)";
+        case MemoryCategory::BUFFERS: return "buffers de saída";
+        case MemoryCategory::HISTORY: return "histórico";
+        case MemoryCategory::REGISTRY: return "registro/presença";
+        case MemoryCategory::FEDERATION: return "federação";
+        case MemoryCategory::LOGGER: return "logger";
+        case MemoryCategory::COUNT: break;
+    }
+    return "?";
+}
+
+int64_t MemoryStats::estimate(const std::string& s) {
+    // Até 15 caracteres a libstdc++ guarda o texto dentro do próprio objeto (SSO)
+    int64_t heap = s.capacity() > 15 ? static_cast<int64_t>(s.capacity()) + 1 : 0;
+    return static_cast<int64_t>(sizeof(std::string)) + heap;
+}
+
+size_t MemoryStats::getThreadStackSize() {
+    static const size_t stack_size = [] {
+        size_t size = 0;
+        pthread_attr_t attr;
+        if (pthread_attr_init(&attr) == 0) {
+            pthread_attr_getstacksize(&attr, &size);
+            pthread_attr_destroy(&attr);
+        }
+        return size;
+    }();
+    return stack_size;
+}
+
+std::string MemoryStats::formatBytes(double bytes) {
+    const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 4) {
+        bytes /= 1024.0;
+        ++unit;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), unit == 0 ? "%.0f %s" : "%.1f %s", bytes, units[unit]);
+    return buf;
+}
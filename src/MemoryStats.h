@@ -0,0 +1,78 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Subsistemas com memória contabilizada
+enum class MemoryCategory {
+    SESSIONS,      // objetos ClientSession (+ bloco de controle do shared_ptr) e nomes
+    THREAD_STACKS, // pilhas reservadas das threads de sessão (memória virtual)
+    BUFFERS,       // filas de saída das sessões e anéis de memória compartilhada
+    HISTORY,       // MessageHistory e o cache de quadros de replay
+    REGISTRY,      // mapa de sessões do ClientManager e lista de presença
+    FEDERATION,    // filas dos links de pares e tabela de de-duplicação
+    LOGGER,        // formatos e buffers do ThreadSafeLogger
+    COUNT
+};
+
+// Contabilidade de memória por subsistema: contadores atômicos atualizados
+// por cada estrutura quando cresce ou encolhe. São estimativas dos bytes de
+// heap (tamanho dos dados + cabeçalhos dos contêineres), não medidas do alocador.
+// O limite opcional liga o descarte: novas conexões são recusadas e o chat
+// (BULK) deixa de ser enfileirado enquanto o total estiver acima dele.
+class MemoryStats {
+public:
+    // Cabeçalho aproximado de um nó de std::map (cor + 3 ponteiros)
+    static const size_t MAP_NODE_OVERHEAD = 32;
+
+    static void add(MemoryCategory category, int64_t bytes) {
+        counters_[static_cast<int>(category)].fetch_add(bytes, std::memory_order_relaxed);
+    }
+    static void sub(MemoryCategory category, int64_t bytes) {
+        counters_[static_cast<int>(category)].fetch_sub(bytes, std::memory_order_relaxed);
+    }
+    static void set(MemoryCategory category, int64_t bytes) {
+        counters_[static_cast<int>(category)].store(bytes, std::memory_order_relaxed);
+    }
+    static int64_t get(MemoryCategory category) {
+        return counters_[static_cast<int>(category)].load(std::memory_order_relaxed);
+    }
+
+    // Soma das categorias de heap (as pilhas ficam de fora: são reserva virtual)
+    static int64_t getHeapTotal();
+
+    static const char* getName(MemoryCategory category);
+
+    // Bytes estimados de uma string guardada num contêiner
+    static int64_t estimate(const std::string& s);
+
+    // Tamanho da pilha de uma std::thread nova (padrão da glibc)
+    static size_t getThreadStackSize();
+
+    // 0 = sem limite
+    static void setLimit(size_t bytes) { limit_ = bytes; }
+    static size_t getLimit() { return limit_; }
+    static bool isOverLimit() {
+        size_t limit = limit_.load(std::memory_order_relaxed);
+        return limit > 0 && getHeapTotal() > static_cast<int64_t>(limit);
+    }
+
+    // Contadores de descarte
+    static void countRejectedConnection() { rejected_connections_.fetch_add(1, std::memory_order_relaxed); }
+    static void countShedMessage() { shed_messages_.fetch_add(1, std::memory_order_relaxed); }
+    static uint64_t getRejectedConnections() { return rejected_connections_.load(std::memory_order_relaxed); }
+    static uint64_t getShedMessages() { return shed_messages_.load(std::memory_order_relaxed); }
+
+    static std::string formatBytes(double bytes);
+
+private:
+    static std::atomic<int64_t> counters_[static_cast<int>(MemoryCategory::COUNT)];
+    static std::atomic<size_t> limit_;
+    static std::atomic<uint64_t> rejected_connections_;
+    static std::atomic<uint64_t> shed_messages_;
+};
+
+#endif // MEMORY_STATS_H
@@ -1,6 +1,21 @@
 #include "MessageHistory.h"
+#include "FrameCodec.h"
+#include "MemoryStats.h"
 #include <iostream>
 
+MessageHistory::~MessageHistory() {
+    MemoryStats::sub(MemoryCategory::HISTORY, accounted_bytes_);
+}
+
+void MessageHistory::clearFrameCacheLocked() const {
+    for (const auto& entry : frame_cache_) {
+        int64_t bytes = MemoryStats::MAP_NODE_OVERHEAD + MemoryStats::estimate(entry.second);
+        accounted_bytes_ -= bytes;
+        MemoryStats::sub(MemoryCategory::HISTORY, bytes);
+    }
+    frame_cache_.clear();
+}
+
 void MessageHistory::addMessage(const std::string& sender, const std::string& message) {
     // 1. Bloqueio da exclusão mútua
     std::lock_guard<std::mutex> lock(history_mutex_); 
@@ -10,10 +25,17 @@ void MessageHistory::addMessage(const std::string& sender, const std::string& me
     
     // 2. Adiciona a mensagem formatada
     history_messages_.push_back(ss.str());
+    ++version_;
+    int64_t added = MemoryStats::estimate(history_messages_.back());
+    accounted_bytes_ += added;
+    MemoryStats::add(MemoryCategory::HISTORY, added);
 
     // 3. Limpeza: Mantém apenas as últimas N mensagens
     if (history_messages_.size() > HISTORY_MAX_SIZE) {
         // Remove os elementos mais antigos
+        int64_t removed = MemoryStats::estimate(history_messages_.front());
+        accounted_bytes_ -= removed;
+        MemoryStats::sub(MemoryCategory::HISTORY, removed);
         history_messages_.erase(history_messages_.begin());
     }
     
@@ -42,4 +64,36 @@ std::vector<std::string> MessageHistory::getLastN(size_t n) const {
         history_messages_.begin() + start_index,
         history_messages_.end()
     );
-}
\ No newline at end of file
+}
+
+std::string MessageHistory::getLastNFrame(size_t n, bool compress) const {
+    if (n > HISTORY_MAX_SIZE) n = HISTORY_MAX_SIZE;
+    auto key = std::make_pair(n, compress);
+
+    std::vector<std::string> lines;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(history_mutex_);
+        if (frame_cache_version_ != version_) {
+            clearFrameCacheLocked();
+            frame_cache_version_ = version_;
+        }
+        auto it = frame_cache_.find(key);
+        if (it != frame_cache_.end()) return it->second;
+
+        size_t start_index = history_messages_.size() > n ? history_messages_.size() - n : 0;
+        lines.assign(history_messages_.begin() + start_index, history_messages_.end());
+        version = version_;
+    }
+
+    // A compressão roda fora do lock; o resultado só entra no cache se o histórico não mudou
+    std::string frame = FrameCodec::encodeBatch(lines, compress);
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    if (version == version_ && frame_cache_.find(key) == frame_cache_.end()) {
+        frame_cache_[key] = frame;
+        int64_t bytes = MemoryStats::MAP_NODE_OVERHEAD + MemoryStats::estimate(frame);
+        accounted_bytes_ += bytes;
+        MemoryStats::add(MemoryCategory::HISTORY, bytes);
+    }
+    return frame;
+}
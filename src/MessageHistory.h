@@ -1,6 +1,8 @@
 #ifndef MESSAGE_HISTORY_H
 #define MESSAGE_HISTORY_H
 
+#include <cstdint>
+#include <map>
 #include <vector>
 #include <string>
 #include <mutex>
@@ -13,10 +15,20 @@ class MessageHistory {
 private:
     std::vector<std::string> history_messages_;
     mutable std::mutex history_mutex_; // Exclusão Mútua para proteger o vector
+    uint64_t version_ = 0;             // muda a cada addMessage
+
+    // Quadros de replay já montados, por (N, comprimido): numa onda de
+    // reconexões todos pedem o mesmo histórico, que só é comprimido uma vez
+    mutable std::map<std::pair<size_t, bool>, std::string> frame_cache_;
+    mutable uint64_t frame_cache_version_ = 0;
+    mutable int64_t accounted_bytes_ = 0; // lançado em MemoryStats (HISTORY)
+
+    void clearFrameCacheLocked() const;
 
 public:
     // Construtor
     MessageHistory() = default;
+    ~MessageHistory();
 
     // Adiciona uma mensagem ao histórico de forma thread-safe
     void addMessage(const std::string& sender, const std::string& message);
@@ -26,6 +38,9 @@ public:
 
     // Método opcional para obter as últimas N mensagens
     std::vector<std::string> getLastN(size_t n) const;
+
+    // As últimas N mensagens num único quadro "@batch" (ver FrameCodec)
+    std::string getLastNFrame(size_t n, bool compress) const;
 };
 
 #endif // MESSAGE_HISTORY_H
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "OutboundQueue.h"
+#include "MemoryStats.h"
+
+OutboundQueue::OutboundQueue(size_t max_bulk_bytes) : max_bulk_bytes_(max_bulk_bytes) {}
+
+OutboundQueue::~OutboundQueue() {
+    MemoryStats::sub(MemoryCategory::BUFFERS, accounted_bytes_);
+}
+
+bool OutboundQueue::push(const std::string& message, MessagePriority priority, const std::string& sender) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) return false;
+
+        int64_t bytes = 0;
+        if (priority == MessagePriority::CONTROL) {
+            control_.push_back(message);
+            control_bytes_ += message.size();
+            bytes = MemoryStats::estimate(control_.back());
+        } else {
+            // Cliente lento: descarta chat novo, mas nunca mensagens de controle
+            if (bulk_bytes_ + message.size() > max_bulk_bytes_) {
+                ++dropped_;
+                return true;
+            }
+            // Servidor acima do limite de memória: o chat é o que se descarta primeiro
+            if (MemoryStats::isOverLimit()) {
+                ++dropped_;
+                MemoryStats::countShedMessage();
+                return true;
+            }
+            SenderQueue& q = bulk_[sender];
+            if (q.messages.empty()) active_senders_.push_back(sender);
+            q.messages.push_back(message);
+            bulk_bytes_ += message.size();
+            bytes = MemoryStats::estimate(q.messages.back());
+        }
+        accounted_bytes_ += bytes;
+        MemoryStats::add(MemoryCategory::BUFFERS, bytes);
+    }
+    cond_var_.notify_one();
+    return true;
+}
+
+void OutboundQueue::releaseLocked(const std::string& message) {
+    int64_t bytes = MemoryStats::estimate(message);
+    accounted_bytes_ -= bytes;
+    MemoryStats::sub(MemoryCategory::BUFFERS, bytes);
+}
+
+// Tira uma mensagem respeitando as prioridades; budget limita o tamanho aceito
+bool OutboundQueue::popOneLocked(std::string& out, size_t budget) {
+    if (!control_.empty()) {
+        if (control_.front().size() > budget) return false;
+        control_bytes_ -= control_.front().size();
+        out += control_.front();
+        releaseLocked(control_.front());
+        control_.pop_front();
+        return true;
+    }
+
+    // Deficit round-robin: o remetente da vez gasta seu crédito e então passa a vez
+    while (!active_senders_.empty()) {
+        const std::string sender = active_senders_.front();
+        SenderQueue& q = bulk_[sender];
+        const std::string& next = q.messages.front();
+
+        if (next.size() <= q.deficit) {
+            if (next.size() > budget) return false;
+            q.deficit -= next.size();
+            bulk_bytes_ -= next.size();
+            out += next;
+            releaseLocked(next);
+            q.messages.pop_front();
+            if (q.messages.empty()) {
+                bulk_.erase(sender);
+                active_senders_.pop_front();
+            }
+            return true;
+        }
+
+        q.deficit += BULK_QUANTUM;
+        active_senders_.pop_front();
+        active_senders_.push_back(sender);
+    }
+    return false;
+}
+
+bool OutboundQueue::popBatch(std::string& out, size_t max_bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_var_.wait(lock, [this] { return closed_ || !control_.empty() || !active_senders_.empty(); });
+
+    out.clear();
+    // A primeira mensagem sai mesmo que seja maior que max_bytes
+    if (!popOneLocked(out, static_cast<size_t>(-1))) return false;
+    while (out.size() < max_bytes && popOneLocked(out, max_bytes - out.size())) {}
+    return true;
+}
+
+void OutboundQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    cond_var_.notify_all();
+}
+
+size_t OutboundQueue::getControlBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return control_bytes_;
+}
+
+size_t OutboundQueue::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
@@ -0,0 +1,66 @@
+#ifndef OUTBOUND_QUEUE_H
+#define OUTBOUND_QUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Classes de prioridade da saída de uma sessão
+enum class MessagePriority {
+    CONTROL, // avisos do servidor, heartbeats: passam na frente de tudo
+    BULK     // mensagens de chat: divididas de forma justa entre remetentes
+};
+
+// Monitor com a fila de saída de uma sessão. CONTROL é FIFO e sempre sai
+// primeiro; BULK tem uma fila por remetente, atendidas em deficit round-robin
+// (quantum em bytes), para que um remetente volumoso não atrase os outros.
+class OutboundQueue {
+public:
+    static const size_t BULK_QUANTUM = 4096;
+
+    explicit OutboundQueue(size_t max_bulk_bytes);
+    ~OutboundQueue();
+
+    // false só se a fila estiver fechada. BULK acima do limite de bytes, ou com o
+    // servidor acima do limite de memória (MemoryStats), é descartado (e contado),
+    // sem derrubar a sessão.
+    bool push(const std::string& message, MessagePriority priority, const std::string& sender);
+
+    // Bloqueia até haver dados; junta mensagens até max_bytes (CONTROL antes de BULK).
+    // Retorna false quando a fila foi fechada e esvaziada.
+    bool popBatch(std::string& out, size_t max_bytes);
+
+    // Impede novos pushes; popBatch ainda entrega o que já estava na fila
+    void close();
+
+    size_t getDroppedCount() const;
+
+    // Bytes de CONTROL ainda não entregues ao socket
+    size_t getControlBytes() const;
+
+private:
+    struct SenderQueue {
+        std::deque<std::string> messages;
+        size_t deficit = 0;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::deque<std::string> control_;
+    std::map<std::string, SenderQueue> bulk_;
+    std::deque<std::string> active_senders_; // ordem do round-robin
+    size_t bulk_bytes_ = 0;
+    size_t control_bytes_ = 0;
+    size_t max_bulk_bytes_;
+    size_t dropped_ = 0;
+    int64_t accounted_bytes_ = 0; // lançado em MemoryStats (BUFFERS)
+    bool closed_ = false;
+
+    bool popOneLocked(std::string& out, size_t budget);
+    void releaseLocked(const std::string& message);
+};
+
+#endif // OUTBOUND_QUEUE_H
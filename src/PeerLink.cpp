@@ -0,0 +1,260 @@
+#include "PeerLink.h"
+#include "LzCodec.h"
+#include "MemoryStats.h"
+
+#include <sys/socket.h>   // send(), recv(), shutdown()
+#include <unistd.h>       // close()
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define PEER_BUFFER_SIZE 16384
+// Maior lote descomprimido aceito (um valor maior indica quadro corrompido)
+#define PEER_MAX_RAW_BATCH (16 * 1024 * 1024)
+// Lotes menores que isso não compensam a compressão
+#define PEER_COMPRESS_MIN 512
+
+// Envia todos os bytes (partial writes); false se o par desconectou
+static bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        return false;
+    }
+    return true;
+}
+
+// Formato do registro: "<origin> <seq> <len_sender> <len_msg>\n<sender><message>"
+static std::string encodeRecord(const PeerRecord& r) {
+    std::string out = r.origin + " " + std::to_string(r.seq) + " " +
+                      std::to_string(r.sender.size()) + " " +
+                      std::to_string(r.message.size()) + "\n";
+    out += r.sender;
+    out += r.message;
+    return out;
+}
+
+PeerLink::PeerLink(int socket_fd, const std::string& local_node, bool outbound,
+                   RecordHandler on_record, CloseHandler on_close, HelloHandler on_hello)
+    : socket_fd_(socket_fd),
+      local_node_(local_node),
+      outbound_(outbound),
+      on_record_(std::move(on_record)),
+      on_close_(std::move(on_close)),
+      on_hello_(std::move(on_hello))
+{
+    TSLOG(DEBUG, "PeerLink criado para o socket " + std::to_string(socket_fd_));
+}
+
+void PeerLink::start() {
+    // O HELLO é a primeira coisa no fio, antes de qualquer lote
+    outbox_.push("HELLO " + local_node_ + " lz\n");
+
+    // As threads mantêm o link vivo até terminarem
+    auto self = shared_from_this();
+    sender_thread_ = std::thread([self] { self->senderLoop(); });
+    receiver_thread_ = std::thread([self] { self->receiverLoop(); });
+}
+
+void PeerLink::enqueue(const PeerRecord& record) {
+    if (!open_) return;
+    std::string encoded = encodeRecord(record);
+    int64_t bytes = MemoryStats::estimate(encoded);
+    outbox_bytes_ += bytes;
+    MemoryStats::add(MemoryCategory::FEDERATION, bytes);
+    outbox_.push(std::move(encoded));
+}
+
+void PeerLink::releaseRecord(const std::string& record) {
+    int64_t bytes = MemoryStats::estimate(record);
+    outbox_bytes_ -= bytes;
+    MemoryStats::sub(MemoryCategory::FEDERATION, bytes);
+}
+
+std::string PeerLink::getRemoteNode() {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return remote_node_;
+}
+
+void PeerLink::close() {
+    {
+        // Sob o mutex para não perder a notificação de waitClosed()
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (!open_) return;
+        open_ = false;
+    }
+    // Acorda o receptor (read retorna 0) e o emissor (sentinela)
+    ::shutdown(socket_fd_, SHUT_RDWR);
+    outbox_.push(std::string());
+    closed_cv_.notify_all();
+}
+
+void PeerLink::waitClosed() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    closed_cv_.wait(lock, [this] { return !open_; });
+}
+
+// Agrupa tudo o que já está na fila em um único "BATCH <n> <bytes>\n<registros>"
+void PeerLink::senderLoop() {
+    while (open_) {
+        std::string first = outbox_.wait_and_pop();
+        if (first.empty()) break; // sentinela
+
+        // O HELLO não é um registro: vai sozinho
+        if (first.compare(0, 6, "HELLO ") == 0) {
+            if (!sendAll(socket_fd_, first)) break;
+            continue;
+        }
+
+        releaseRecord(first);
+        std::string payload = std::move(first);
+        size_t count = 1;
+        std::string next;
+        bool stop = false;
+        while (count < MAX_BATCH_RECORDS && payload.size() < MAX_BATCH_BYTES && outbox_.try_pop(next)) {
+            if (next.empty()) { stop = true; break; }
+            releaseRecord(next);
+            payload += next;
+            ++count;
+        }
+
+        std::string frame;
+        std::string packed;
+        if (peer_lz_ && payload.size() >= PEER_COMPRESS_MIN) {
+            packed = LzCodec::compress(payload);
+        }
+        if (!packed.empty() && packed.size() < payload.size()) {
+            frame = "BATCHZ " + std::to_string(count) + " " + std::to_string(payload.size()) + " " +
+                    std::to_string(packed.size()) + "\n";
+            frame += packed;
+        } else {
+            frame = "BATCH " + std::to_string(count) + " " + std::to_string(payload.size()) + "\n";
+            frame += payload;
+        }
+        if (!sendAll(socket_fd_, frame)) {
+            TSLOG(WARNING, "Falha ao enviar lote para o par (socket " + std::to_string(socket_fd_) + ")");
+            break;
+        }
+        if (stop) break;
+    }
+    close();
+}
+
+bool PeerLink::parseBatch(const std::string& payload, size_t count) {
+    size_t pos = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t eol = payload.find('\n', pos);
+        if (eol == std::string::npos) return false;
+
+        PeerRecord record;
+        size_t sender_len = 0, msg_len = 0;
+        std::istringstream header(payload.substr(pos, eol - pos));
+        if (!(header >> record.origin >> record.seq >> sender_len >> msg_len)) return false;
+
+        pos = eol + 1;
+        if (payload.size() - pos < sender_len + msg_len) return false;
+        record.sender = payload.substr(pos, sender_len);
+        record.message = payload.substr(pos + sender_len, msg_len);
+        pos += sender_len + msg_len;
+
+        on_record_(record);
+    }
+    return pos == payload.size();
+}
+
+void PeerLink::receiverLoop() {
+    char buffer[PEER_BUFFER_SIZE];
+    std::string pending;
+    bool ok = true;
+
+    while (ok && open_) {
+        ssize_t n = ::recv(socket_fd_, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buffer, static_cast<size_t>(n));
+
+        // Processa todos os quadros completos do buffer
+        while (ok) {
+            size_t eol = pending.find('\n');
+            if (eol == std::string::npos) break;
+            std::string line = pending.substr(0, eol);
+
+            if (line.compare(0, 6, "HELLO ") == 0) {
+                // "HELLO <nó> [capacidades...]"
+                std::istringstream hello(line.substr(6));
+                std::string node, cap;
+                hello >> node;
+                while (hello >> cap) {
+                    if (cap == "lz") peer_lz_ = true;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(state_mutex_);
+                    remote_node_ = node;
+                }
+                TSLOG(INFO, "Par federado identificado: " + node + " (socket " + std::to_string(socket_fd_) + ")");
+                pending.erase(0, eol + 1);
+                // A federação pode fechar este link se já houver outro para o mesmo nó
+                if (on_hello_) on_hello_(shared_from_this());
+                if (!open_) ok = false;
+                continue;
+            }
+
+            // "BATCH <n> <bytes>" ou "BATCHZ <n> <bytes originais> <bytes comprimidos>"
+            std::istringstream header(line);
+            std::string tag;
+            size_t count = 0, bytes = 0, raw_bytes = 0;
+            bool header_ok = static_cast<bool>(header >> tag >> count >> bytes);
+            if (header_ok && tag == "BATCHZ") {
+                raw_bytes = bytes;
+                header_ok = static_cast<bool>(header >> bytes) && raw_bytes <= PEER_MAX_RAW_BATCH;
+            } else if (tag != "BATCH") {
+                header_ok = false;
+            }
+            if (!header_ok) {
+                TSLOG(ERROR, "Quadro inválido recebido do par (socket " + std::to_string(socket_fd_) + ")");
+                ok = false;
+                break;
+            }
+            if (pending.size() - (eol + 1) < bytes) break; // lote incompleto
+
+            std::string payload = pending.substr(eol + 1, bytes);
+            pending.erase(0, eol + 1 + bytes);
+            if (tag == "BATCHZ") {
+                std::string raw;
+                if (!LzCodec::decompress(payload, raw_bytes, raw)) {
+                    TSLOG(ERROR, "Lote comprimido corrompido recebido do par (socket " + std::to_string(socket_fd_) + ")");
+                    ok = false;
+                    break;
+                }
+                payload.swap(raw);
+            }
+            if (!parseBatch(payload, count)) {
+                TSLOG(ERROR, "Lote malformado recebido do par (socket " + std::to_string(socket_fd_) + ")");
+                ok = false;
+            }
+        }
+    }
+
+    TSLOG(INFO, "Link federado encerrado (socket " + std::to_string(socket_fd_) + ")");
+    close();
+    if (on_close_) on_close_(shared_from_this());
+}
+
+PeerLink::~PeerLink() {
+    // As threads capturam o shared_ptr, então aqui elas já terminaram (ou são a última referência)
+    if (sender_thread_.joinable()) sender_thread_.detach();
+    if (receiver_thread_.joinable()) receiver_thread_.detach();
+    if (socket_fd_ >= 0) ::close(socket_fd_);
+    // Registros que ficaram na fila quando o link caiu
+    MemoryStats::sub(MemoryCategory::FEDERATION, outbox_bytes_);
+    TSLOG(DEBUG, "PeerLink destruído para o socket " + std::to_string(socket_fd_));
+}
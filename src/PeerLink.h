@@ -0,0 +1,91 @@
+#ifndef PEER_LINK_H
+#define PEER_LINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "ThreadSafeQueue.h"
+#include "../libtslog/tslog.h"
+
+// Uma mensagem originada em algum nó da federação
+struct PeerRecord {
+    std::string origin;   // Identificador do nó de origem (node_id#epoch)
+    uint64_t seq = 0;     // Número de sequência no nó de origem (para de-duplicação)
+    std::string sender;
+    std::string message;
+};
+
+// Conexão servidor-servidor. Cada link é bidirecional: uma thread envia os
+// registros enfileirados em lotes (BATCH) e outra lê e decodifica os lotes do par.
+// Se o HELLO do par anunciar "lz", lotes grandes vão comprimidos (BATCHZ).
+class PeerLink : public std::enable_shared_from_this<PeerLink> {
+public:
+    using RecordHandler = std::function<void(const PeerRecord&)>;
+    using CloseHandler = std::function<void(std::shared_ptr<PeerLink>)>;
+    // Chamado quando o HELLO do par chega (o nó remoto já é conhecido)
+    using HelloHandler = std::function<void(std::shared_ptr<PeerLink>)>;
+
+    // Limites de um lote: o que estiver na fila é agrupado até esses valores
+    static const size_t MAX_BATCH_RECORDS = 256;
+    static const size_t MAX_BATCH_BYTES = 64 * 1024;
+
+    // outbound: este nó discou o link (--peer); false para links aceitos na porta de pares
+    PeerLink(int socket_fd, const std::string& local_node, bool outbound,
+             RecordHandler on_record, CloseHandler on_close, HelloHandler on_hello);
+
+    // Envia o HELLO e inicia as threads de envio e recepção
+    void start();
+
+    // Enfileira um registro para o próximo lote (não bloqueante)
+    void enqueue(const PeerRecord& record);
+
+    // Fecha o socket; as threads terminam sozinhas
+    void close();
+
+    // Bloqueia até o link ser fechado (usado pelo reconector)
+    void waitClosed();
+
+    bool isOpen() const { return open_; }
+    bool isOutbound() const { return outbound_; }
+
+    // Fecha o link por haver outro para o mesmo nó (o discador não deve rediscar logo)
+    void closeAsDuplicate() { duplicate_ = true; close(); }
+    bool isDuplicate() const { return duplicate_; }
+    int getSocket() const { return socket_fd_; }
+    std::string getRemoteNode();
+
+    ~PeerLink();
+
+private:
+    int socket_fd_;
+    std::string local_node_;
+    std::string remote_node_;
+    std::mutex state_mutex_;
+    std::condition_variable closed_cv_;
+    std::atomic<bool> open_{true};
+    std::atomic<bool> peer_lz_{false}; // o par aceita BATCHZ
+    bool outbound_;
+    std::atomic<bool> duplicate_{false};
+
+    // Registros já serializados; string vazia é a sentinela de encerramento
+    ThreadSafeQueue<std::string> outbox_;
+    std::atomic<int64_t> outbox_bytes_{0}; // registros na fila, lançados em MemoryStats (FEDERATION)
+
+    RecordHandler on_record_;
+    CloseHandler on_close_;
+    HelloHandler on_hello_;
+    std::thread sender_thread_;
+    std::thread receiver_thread_;
+
+    void senderLoop();
+    void receiverLoop();
+    bool parseBatch(const std::string& payload, size_t count);
+    void releaseRecord(const std::string& record);
+};
+
+#endif // PEER_LINK_H
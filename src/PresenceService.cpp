@@ -0,0 +1,191 @@
+#include "PresenceService.h"
+#include "ClientSession.h"
+#include "MemoryStats.h"
+#include "../libtslog/tslog.h"
+
+#include <vector>
+
+// Um membro ocupa um nó em members_ e outro em names_, e o nome aparece nos dois
+static int64_t memberBytes(const std::string& name) {
+    return 2 * MemoryStats::MAP_NODE_OVERHEAD +
+           sizeof(std::pair<const uint64_t, std::weak_ptr<ClientSession>>) +
+           sizeof(uint64_t) +
+           2 * MemoryStats::estimate(name);
+}
+
+void PresenceService::account(int64_t bytes) {
+    accounted_bytes_ += bytes;
+    MemoryStats::add(MemoryCategory::REGISTRY, bytes);
+}
+
+PresenceService::PresenceService() {
+    flusher_thread_ = std::thread(&PresenceService::flusherLoop, this);
+}
+
+// Guarda o estado anterior na primeira mudança do id dentro da janela
+void PresenceService::noteChangeLocked(uint64_t session_id) {
+    ++version_;
+    if (window_before_.count(session_id)) return;
+    auto it = members_.find(session_id);
+    if (it == members_.end()) {
+        window_before_[session_id] = Before{false, std::string()};
+    } else {
+        window_before_[session_id] = Before{true, it->second.name};
+    }
+}
+
+void PresenceService::join(std::shared_ptr<ClientSession> session) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t id = session->getSessionId();
+        noteChangeLocked(id);
+        std::string name = session->getUsername();
+        if (!members_.count(id)) account(memberBytes(name));
+        members_[id] = Member{session, name};
+        names_[name] = id;
+        needs_snapshot_.insert(id);
+    }
+    cond_var_.notify_one();
+}
+
+void PresenceService::leave(uint64_t session_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = members_.find(session_id);
+        if (it == members_.end()) return;
+        noteChangeLocked(session_id);
+        auto name_it = names_.find(it->second.name);
+        if (name_it != names_.end() && name_it->second == session_id) names_.erase(name_it);
+        account(-memberBytes(it->second.name));
+        members_.erase(it);
+        needs_snapshot_.erase(session_id);
+    }
+    cond_var_.notify_one();
+}
+
+bool PresenceService::rename(uint64_t session_id, const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = members_.find(session_id);
+        if (it == members_.end()) return false;
+        if (it->second.name == name) return true;
+
+        auto taken = names_.find(name);
+        if (taken != names_.end() && taken->second != session_id) return false;
+
+        noteChangeLocked(session_id);
+        names_.erase(it->second.name);
+        account(memberBytes(name) - memberBytes(it->second.name));
+        it->second.name = name;
+        names_[name] = session_id;
+    }
+    cond_var_.notify_one();
+    return true;
+}
+
+void PresenceService::requestSnapshot(uint64_t session_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!members_.count(session_id)) return;
+        needs_snapshot_.insert(session_id);
+    }
+    cond_var_.notify_one();
+}
+
+uint64_t PresenceService::getVersion() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return version_;
+}
+
+size_t PresenceService::getMemberCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return members_.size();
+}
+
+// Espera a primeira mudança, deixa a janela acumular as seguintes e publica
+void PresenceService::flusherLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cond_var_.wait(lock, [this] {
+            return stopping_ || !window_before_.empty() || !needs_snapshot_.empty();
+        });
+        if (stopping_) return;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(window_ms_.load());
+        cond_var_.wait_until(lock, deadline, [this] { return stopping_; });
+        if (stopping_) return;
+
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void PresenceService::flush() {
+    std::string delta;
+    std::string snapshot;
+    std::vector<std::shared_ptr<ClientSession>> delta_to;
+    std::vector<std::shared_ptr<ClientSession>> snapshot_to;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Efeito líquido de cada id alterado na janela
+        std::string changes;
+        for (const auto& p : window_before_) {
+            auto now = members_.find(p.first);
+            if (now != members_.end()) {
+                if (!p.second.present || p.second.name != now->second.name) {
+                    changes += " +" + std::to_string(p.first) + ":" + now->second.name;
+                }
+            } else if (p.second.present) {
+                changes += " -" + std::to_string(p.first);
+            }
+        }
+        window_before_.clear();
+
+        if (!changes.empty()) {
+            delta = "@presence " + std::to_string(published_version_) + " " +
+                    std::to_string(version_) + changes + "\n";
+            published_version_ = version_;
+        }
+
+        if (!needs_snapshot_.empty()) {
+            snapshot = "@roster " + std::to_string(version_) + " ";
+            bool first = true;
+            for (const auto& m : members_) {
+                if (!first) snapshot += ",";
+                snapshot += std::to_string(m.first) + ":" + m.second.name;
+                first = false;
+            }
+            snapshot += "\n";
+        }
+
+        for (const auto& m : members_) {
+            auto session = m.second.session.lock();
+            if (!session) continue;
+            if (needs_snapshot_.count(m.first)) {
+                snapshot_to.push_back(session);
+            } else if (!delta.empty()) {
+                delta_to.push_back(session);
+            }
+        }
+        needs_snapshot_.clear();
+    }
+
+    // Fora do lock: pela faixa de controle, na frente do chat enfileirado
+    for (auto& s : delta_to) s->sendMessage(delta, MessagePriority::CONTROL);
+    for (auto& s : snapshot_to) s->sendMessage(snapshot, MessagePriority::CONTROL);
+}
+
+PresenceService::~PresenceService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_var_.notify_all();
+    if (flusher_thread_.joinable()) {
+        flusher_thread_.join();
+    }
+    MemoryStats::sub(MemoryCategory::REGISTRY, accounted_bytes_);
+}
@@ -0,0 +1,79 @@
+#ifndef PRESENCE_SERVICE_H
+#define PRESENCE_SERVICE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+class ClientSession;
+
+// Lista de presença versionada. Cada entrada/saída/troca de nome incrementa a
+// versão; as mudanças de uma janela curta são agregadas (entrar e sair na mesma
+// janela se cancelam) e enviadas como um único delta para os membros:
+//   @presence <de> <para> +<id>:<nome> -<id> ...
+// Quem entrou na janela recebe, em vez do delta, o snapshot completo:
+//   @roster <versão> <id>:<nome>,<id>:<nome>,...
+// O cliente aplica um delta se de <= versão local < para; fora disso pede /roster.
+// A lista é só deste nó: a federação não repassa presença entre servidores.
+class PresenceService {
+public:
+    static const int DEFAULT_WINDOW_MS = 50;
+
+    PresenceService();
+
+    PresenceService(const PresenceService&) = delete;
+    PresenceService& operator=(const PresenceService&) = delete;
+
+    void join(std::shared_ptr<ClientSession> session);
+    void leave(uint64_t session_id);
+
+    // Troca o nome de um membro; false se já houver outro membro com esse nome
+    bool rename(uint64_t session_id, const std::string& name);
+
+    // Agenda um snapshot completo para o membro (ressincronização)
+    void requestSnapshot(uint64_t session_id);
+
+    void setWindow(std::chrono::milliseconds window) { window_ms_ = static_cast<int>(window.count()); }
+    uint64_t getVersion();
+    size_t getMemberCount();
+
+    ~PresenceService();
+
+private:
+    struct Member {
+        std::weak_ptr<ClientSession> session;
+        std::string name;
+    };
+    // Estado de um membro antes da janela atual (para agregar as mudanças)
+    struct Before {
+        bool present;
+        std::string name;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::map<uint64_t, Member> members_;
+    std::map<std::string, uint64_t> names_;      // nome -> id (nomes únicos)
+    std::map<uint64_t, Before> window_before_;   // ids alterados na janela
+    std::set<uint64_t> needs_snapshot_;
+    uint64_t version_ = 0;
+    uint64_t published_version_ = 0;             // "para" do último delta enviado
+    std::atomic<int> window_ms_{DEFAULT_WINDOW_MS};
+    bool stopping_ = false;
+    std::thread flusher_thread_;
+    int64_t accounted_bytes_ = 0;                // lançado em MemoryStats (REGISTRY)
+
+    void account(int64_t bytes);
+    void noteChangeLocked(uint64_t session_id);
+    void flusherLoop();
+    void flush();
+};
+
+#endif // PRESENCE_SERVICE_H
@@ -0,0 +1,83 @@
+#include "PresenceTracker.h"
+
+#include <sstream>
+
+// "<id>:<nome>"
+static bool parseEntry(const std::string& entry, uint64_t& id, std::string& name) {
+    size_t sep = entry.find(':');
+    if (sep == 0 || sep == std::string::npos || sep + 1 >= entry.size()) return false;
+    try {
+        id = std::stoull(entry.substr(0, sep));
+    } catch (const std::exception&) {
+        return false;
+    }
+    name = entry.substr(sep + 1);
+    return true;
+}
+
+PresenceTracker::Result PresenceTracker::handleLine(const std::string& line, std::vector<Change>* changes) {
+    std::istringstream in(line);
+    std::string kind;
+    in >> kind;
+
+    if (kind == "@roster") {
+        uint64_t version = 0;
+        if (!(in >> version)) return Result::RESYNC;
+        std::map<uint64_t, std::string> members;
+        std::string list, entry;
+        in >> list;
+        std::istringstream entries(list);
+        while (std::getline(entries, entry, ',')) {
+            uint64_t id;
+            std::string name;
+            if (parseEntry(entry, id, name)) members[id] = name;
+        }
+        members_.swap(members);
+        version_ = version;
+        synced_ = true;
+        return Result::APPLIED;
+    }
+
+    if (kind != "@presence") return Result::NOT_PRESENCE;
+
+    uint64_t from = 0, to = 0;
+    if (!(in >> from >> to)) return Result::RESYNC;
+    if (!synced_) return Result::RESYNC;
+    if (to <= version_) return Result::STALE;
+    if (from > version_) {
+        synced_ = false;
+        return Result::RESYNC;
+    }
+
+    // Os deltas trazem o estado final de cada id: aplicar é idempotente
+    std::string token;
+    while (in >> token) {
+        if (token.size() < 2) continue;
+        if (token[0] == '+') {
+            uint64_t id;
+            std::string name;
+            if (!parseEntry(token.substr(1), id, name)) continue;
+            auto it = members_.find(id);
+            if (it == members_.end()) {
+                members_[id] = name;
+                if (changes) changes->push_back(Change{Change::JOINED, id, name, std::string()});
+            } else if (it->second != name) {
+                if (changes) changes->push_back(Change{Change::RENAMED, id, name, it->second});
+                it->second = name;
+            }
+        } else if (token[0] == '-') {
+            uint64_t id;
+            try {
+                id = std::stoull(token.substr(1));
+            } catch (const std::exception&) {
+                continue;
+            }
+            auto it = members_.find(id);
+            if (it == members_.end()) continue;
+            if (changes) changes->push_back(Change{Change::LEFT, id, it->second, std::string()});
+            members_.erase(it);
+        }
+    }
+    version_ = to;
+    return Result::APPLIED;
+}
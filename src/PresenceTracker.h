@@ -0,0 +1,41 @@
+#ifndef PRESENCE_TRACKER_H
+#define PRESENCE_TRACKER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Lado cliente da presença (ver PresenceService): mantém a lista a partir do
+// snapshot "@roster" e aplica os deltas "@presence". Não é thread-safe; use na
+// thread que recebe as linhas.
+class PresenceTracker {
+public:
+    enum class Result {
+        NOT_PRESENCE, // linha comum de chat
+        APPLIED,      // lista atualizada
+        STALE,        // delta já coberto pela versão local; ignorado
+        RESYNC        // lacuna de versão: envie "/roster" para receber um snapshot
+    };
+
+    struct Change {
+        enum Kind { JOINED, LEFT, RENAMED } kind;
+        uint64_t id;
+        std::string name;     // nome atual (em LEFT, o último conhecido)
+        std::string old_name; // só em RENAMED
+    };
+
+    // changes (opcional) recebe o que mudou; um snapshot não gera mudanças
+    Result handleLine(const std::string& line, std::vector<Change>* changes = nullptr);
+
+    bool isSynced() const { return synced_; }
+    uint64_t getVersion() const { return version_; }
+    const std::map<uint64_t, std::string>& getMembers() const { return members_; }
+
+private:
+    std::map<uint64_t, std::string> members_;
+    uint64_t version_ = 0;
+    bool synced_ = false;
+};
+
+#endif // PRESENCE_TRACKER_H
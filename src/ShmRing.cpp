@@ -0,0 +1,191 @@
+#include "ShmRing.h"
+#include "../libtslog/tslog.h"
+
+#include <sys/mman.h>   // shm_open, mmap
+#include <sys/syscall.h> // SYS_futex
+#include <linux/futex.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>     // ftruncate, close
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+ShmRing::ShmRing(const std::string& name, void* base, size_t capacity, size_t mapped_size, bool owner)
+    : name_(name),
+      header_(static_cast<Header*>(base)),
+      data_(static_cast<char*>(base) + sizeof(Header)),
+      capacity_(capacity),
+      mapped_size_(mapped_size),
+      owner_(owner)
+{
+}
+
+std::unique_ptr<ShmRing> ShmRing::create(const std::string& name, size_t capacity) {
+    size_t cap = 4096;
+    while (cap < capacity) cap <<= 1;
+    size_t total = sizeof(Header) + cap;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        TSLOG(ERROR, "shm_open falhou para " + name + ": " + std::strerror(errno));
+        throw std::runtime_error("Falha ao criar memória compartilhada.");
+    }
+    if (ftruncate(fd, static_cast<off_t>(total)) < 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Falha ao dimensionar memória compartilhada.");
+    }
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Falha ao mapear memória compartilhada.");
+    }
+
+    Header* h = static_cast<Header*>(base);
+    h->capacity = static_cast<uint32_t>(cap);
+    h->head.store(0, std::memory_order_relaxed);
+    h->tail.store(0, std::memory_order_relaxed);
+    h->closed.store(0, std::memory_order_relaxed);
+    h->sleeping.store(0, std::memory_order_relaxed);
+    h->wake_seq.store(0, std::memory_order_relaxed);
+    // O magic por último: o servidor só aceita um anel já inicializado
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = MAGIC;
+
+    return std::unique_ptr<ShmRing>(new ShmRing(name, base, cap, total, true));
+}
+
+std::unique_ptr<ShmRing> ShmRing::open(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        TSLOG(ERROR, "shm_open falhou para " + name + ": " + std::strerror(errno));
+        throw std::runtime_error("Falha ao abrir memória compartilhada.");
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) <= sizeof(Header)) {
+        ::close(fd);
+        throw std::runtime_error("Segmento de memória compartilhada inválido.");
+    }
+    size_t total = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Falha ao mapear memória compartilhada.");
+    }
+
+    Header* h = static_cast<Header*>(base);
+    uint32_t cap = h->capacity;
+    if (h->magic != MAGIC || cap == 0 || (cap & (cap - 1)) != 0 || sizeof(Header) + cap > total) {
+        munmap(base, total);
+        throw std::runtime_error("Segmento de memória compartilhada inválido.");
+    }
+    // O nome só serve para o handshake: removê-lo já evita vazar o segmento se o cliente cair
+    shm_unlink(name.c_str());
+    return std::unique_ptr<ShmRing>(new ShmRing(name, base, cap, total, false));
+}
+
+void ShmRing::copyIn(uint64_t pos, const char* src, size_t len) {
+    size_t cap = capacity_;
+    size_t offset = static_cast<size_t>(pos & (cap - 1));
+    size_t first = std::min(len, cap - offset);
+    std::memcpy(data_ + offset, src, first);
+    std::memcpy(data_, src + first, len - first);
+}
+
+void ShmRing::copyOut(uint64_t pos, char* dst, size_t len) const {
+    size_t cap = capacity_;
+    size_t offset = static_cast<size_t>(pos & (cap - 1));
+    size_t first = std::min(len, cap - offset);
+    std::memcpy(dst, data_ + offset, first);
+    std::memcpy(dst + first, data_, len - first);
+}
+
+bool ShmRing::push(const std::string& message) {
+    uint32_t len = static_cast<uint32_t>(message.size());
+    size_t needed = sizeof(len) + len;
+    if (needed > capacity_) return false;
+
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    if (capacity_ - (head - tail) < needed) return false;
+
+    copyIn(head, reinterpret_cast<const char*>(&len), sizeof(len));
+    copyIn(head + sizeof(len), message.data(), len);
+    header_->head.store(head + needed, std::memory_order_release);
+
+    // Par com o seq_cst de waitForData: ou o consumidor vê o novo head, ou aqui se vê sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->sleeping.load(std::memory_order_relaxed) != 0) {
+        wakeConsumer();
+    }
+    return true;
+}
+
+bool ShmRing::pop(std::string& message) {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    if (head == tail) return false;
+
+    uint32_t len = 0;
+    if (head - tail > capacity_ || head - tail < sizeof(len)) {
+        header_->closed.store(1, std::memory_order_release);
+        return false;
+    }
+    copyOut(tail, reinterpret_cast<char*>(&len), sizeof(len));
+    if (sizeof(len) + len > head - tail) {
+        // Produtor corrompeu o anel: trata como encerrado
+        header_->closed.store(1, std::memory_order_release);
+        return false;
+    }
+    message.resize(len);
+    copyOut(tail + sizeof(len), &message[0], len);
+    header_->tail.store(tail + sizeof(len) + len, std::memory_order_release);
+    return true;
+}
+
+// Futex compartilhado entre processos (sem FUTEX_PRIVATE_FLAG): a palavra está no segmento
+static long futexCall(std::atomic<uint32_t>* word, int op, uint32_t value, const struct timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+void ShmRing::waitForData(std::chrono::milliseconds timeout) {
+    uint32_t seq = header_->wake_seq.load(std::memory_order_acquire);
+    header_->sleeping.store(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Confere de novo depois de anunciar o sono: um push no meio não se perde
+    bool empty = header_->head.load(std::memory_order_acquire) == header_->tail.load(std::memory_order_relaxed);
+    if (empty && !isClosed()) {
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+        futexCall(&header_->wake_seq, FUTEX_WAIT, seq, &ts); // EAGAIN/ETIMEDOUT/EINTR: volta ao loop
+    }
+    header_->sleeping.store(0, std::memory_order_relaxed);
+}
+
+void ShmRing::wakeConsumer() {
+    header_->wake_seq.fetch_add(1, std::memory_order_release);
+    futexCall(&header_->wake_seq, FUTEX_WAKE, 1, nullptr);
+}
+
+void ShmRing::markClosed() {
+    header_->closed.store(1, std::memory_order_release);
+    wakeConsumer();
+}
+
+bool ShmRing::isClosed() const {
+    return header_->closed.load(std::memory_order_acquire) != 0;
+}
+
+ShmRing::~ShmRing() {
+    if (header_ != nullptr) {
+        munmap(header_, mapped_size_);
+    }
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Anel SPSC (um produtor, um consumidor) em memória compartilhada POSIX.
+// Usado como transporte local cliente -> servidor: o cliente cria o segmento,
+// anuncia o nome pelo socket (/shm <nome>) e passa a escrever as mensagens aqui.
+// Cada registro é um tamanho de 32 bits seguido dos bytes, com wrap-around.
+// O consumidor ocioso dorme num futex do cabeçalho; o produtor só faz a
+// chamada de sistema para acordá-lo quando ele marcou que está dormindo.
+class ShmRing {
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t capacity;               // bytes da área de dados (potência de 2)
+        std::atomic<uint64_t> head;      // posição de escrita (só o produtor altera)
+        std::atomic<uint64_t> tail;      // posição de leitura (só o consumidor altera)
+        std::atomic<uint32_t> closed;    // produtor encerrou
+        std::atomic<uint32_t> sleeping;  // consumidor parado no futex
+        std::atomic<uint32_t> wake_seq;  // palavra do futex (muda a cada aviso)
+    };
+
+    std::string name_;
+    Header* header_ = nullptr;
+    char* data_ = nullptr;
+    size_t capacity_ = 0;  // copiada na abertura: o outro processo não pode alterá-la
+    size_t mapped_size_ = 0;
+    bool owner_ = false; // quem criou remove o segmento no destrutor
+
+    ShmRing(const std::string& name, void* base, size_t capacity, size_t mapped_size, bool owner);
+
+    void copyIn(uint64_t pos, const char* src, size_t len);
+    void copyOut(uint64_t pos, char* dst, size_t len) const;
+
+public:
+    static const uint32_t MAGIC = 0x43485352; // "CHSR"
+    static const size_t DEFAULT_CAPACITY = 1 << 20;
+
+    // Lado do cliente: cria o segmento (capacity é arredondada para potência de 2)
+    static std::unique_ptr<ShmRing> create(const std::string& name, size_t capacity = DEFAULT_CAPACITY);
+
+    // Lado do servidor: abre um segmento existente
+    static std::unique_ptr<ShmRing> open(const std::string& name);
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // Produtor: false se não houver espaço (o chamador decide esperar)
+    bool push(const std::string& message);
+
+    // Consumidor: false se o anel estiver vazio
+    bool pop(std::string& message);
+
+    // Consumidor: dorme até haver dados, o anel fechar, wakeConsumer() ou o timeout.
+    // O timeout limita a espera se o outro processo não avisar.
+    void waitForData(std::chrono::milliseconds timeout);
+
+    // Acorda o consumidor (usado também pelo próprio servidor para encerrá-lo)
+    void wakeConsumer();
+
+    void markClosed();
+    bool isClosed() const;
+    const std::string& getName() const { return name_; }
+    size_t getCapacity() const { return capacity_; }
+
+    ~ShmRing();
+};
+
+#endif // SHM_RING_H
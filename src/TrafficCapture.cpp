@@ -0,0 +1,134 @@
+#include "TrafficCapture.h"
+#include "../libtslog/tslog.h"
+
+#include <stdexcept>
+
+// No máximo esta janela de eventos se perde se o servidor morrer por sinal
+#define CAPTURE_FLUSH_INTERVAL_MS 1000
+// Maior mensagem aceita na leitura (um tamanho maior indica arquivo corrompido)
+#define CAPTURE_MAX_PAYLOAD (16 * 1024 * 1024)
+
+static void writeVarint(std::ofstream& out, uint64_t value) {
+    char buf[10];
+    size_t n = 0;
+    while (value >= 0x80) {
+        buf[n++] = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = static_cast<char>(value);
+    out.write(buf, n);
+}
+
+static bool readVarint(std::ifstream& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if (c == EOF) return false;
+        value |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+TrafficCapture::TrafficCapture(const std::string& path)
+    : start_(std::chrono::steady_clock::now())
+{
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        TSLOG(ERROR, "Falha ao abrir arquivo de captura " + path);
+        throw std::runtime_error("Falha ao abrir arquivo de captura.");
+    }
+
+    auto wall = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    file_.write("CHCAP", 5);
+    file_.put(static_cast<char>(VERSION));
+    writeVarint(file_, static_cast<uint64_t>(wall));
+    file_.flush();
+    TSLOG(INFO, "Captura de tráfego em " + path);
+
+    flusher_thread_ = std::thread(&TrafficCapture::flusherLoop, this);
+}
+
+void TrafficCapture::flusherLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        stop_cv_.wait_for(lock, std::chrono::milliseconds(CAPTURE_FLUSH_INTERVAL_MS));
+        file_.flush();
+    }
+}
+
+void TrafficCapture::record(CaptureEvent type, uint64_t connection, const std::string& payload) {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t now_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - start_).count());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Threads diferentes podem medir fora de ordem; o delta nunca é negativo
+    if (now_us < last_us_) now_us = last_us_;
+
+    file_.put(static_cast<char>(type));
+    writeVarint(file_, now_us - last_us_);
+    writeVarint(file_, connection);
+    writeVarint(file_, payload.size());
+    file_.write(payload.data(), payload.size());
+    last_us_ = now_us;
+    ++records_;
+}
+
+void TrafficCapture::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.flush();
+}
+
+TrafficCapture::~TrafficCapture() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    if (flusher_thread_.joinable()) {
+        flusher_thread_.join();
+    }
+    TSLOG(INFO, "Captura encerrada com " + std::to_string(records_) + " eventos.");
+}
+
+std::vector<CaptureRecord> TrafficCapture::readAll(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Falha ao abrir captura " + path);
+    }
+
+    char magic[5];
+    in.read(magic, 5);
+    int version = in.get();
+    uint64_t wall_start = 0;
+    if (!in || std::string(magic, 5) != "CHCAP" || version != VERSION || !readVarint(in, wall_start)) {
+        throw std::runtime_error("Arquivo de captura inválido: " + path);
+    }
+
+    std::vector<CaptureRecord> records;
+    uint64_t now_us = 0;
+    while (true) {
+        int type = in.get();
+        if (type == EOF) break;
+
+        uint64_t delta = 0, connection = 0, length = 0;
+        if (type < 1 || type > 3 || !readVarint(in, delta) || !readVarint(in, connection) || !readVarint(in, length)) {
+            // Cauda truncada (servidor morto no meio de uma escrita): fica com o que já foi lido
+            break;
+        }
+
+        if (length > CAPTURE_MAX_PAYLOAD) break;
+
+        CaptureRecord r;
+        r.type = static_cast<CaptureEvent>(type);
+        now_us += delta;
+        r.timestamp_us = now_us;
+        r.connection = connection;
+        r.payload.resize(length);
+        if (length > 0 && !in.read(&r.payload[0], length)) break;
+        records.push_back(std::move(r));
+    }
+    return records;
+}
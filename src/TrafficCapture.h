@@ -0,0 +1,63 @@
+#ifndef TRAFFIC_CAPTURE_H
+#define TRAFFIC_CAPTURE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tipos de evento gravados na captura
+enum class CaptureEvent : uint8_t {
+    JOIN = 1,
+    LEAVE = 2,
+    MESSAGE = 3
+};
+
+struct CaptureRecord {
+    CaptureEvent type;
+    uint64_t timestamp_us; // desde o início da captura
+    uint64_t connection;   // id da sessão (não o fd, que é reutilizado)
+    std::string payload;   // texto da mensagem (vazio em JOIN/LEAVE)
+};
+
+// Grava o tráfego de entrada do servidor num arquivo binário compacto:
+//   cabeçalho "CHCAP" + versão (1 byte) + início em µs desde a época (varint)
+//   registros: tipo (1 byte), delta de tempo em µs (varint), conexão (varint),
+//              tamanho (varint), bytes da mensagem
+class TrafficCapture {
+public:
+    static const uint8_t VERSION = 1;
+
+    explicit TrafficCapture(const std::string& path);
+
+    TrafficCapture(const TrafficCapture&) = delete;
+    TrafficCapture& operator=(const TrafficCapture&) = delete;
+
+    void record(CaptureEvent type, uint64_t connection, const std::string& payload = std::string());
+    void flush();
+
+    ~TrafficCapture();
+
+    // Lê uma captura inteira (usado pela ferramenta de replay); lança em caso de erro
+    static std::vector<CaptureRecord> readAll(const std::string& path);
+
+private:
+    std::ofstream file_;
+    std::mutex mutex_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t last_us_ = 0;
+    size_t records_ = 0;
+
+    // O servidor costuma ser encerrado por sinal: uma thread faz flush periódico
+    std::thread flusher_thread_;
+    std::condition_variable stop_cv_;
+    bool stopping_ = false;
+
+    void flusherLoop();
+};
+
+#endif // TRAFFIC_CAPTURE_H
@@ -0,0 +1,162 @@
+// Arquivo: src/codec_test.cpp
+// Testes do LzCodec e do FrameCodec, que decodificam dados vindos da rede
+// (lotes "@batch" do servidor e BATCHZ entre nós da federação).
+// Sai com status 1 se alguma verificação falhar.
+
+#include "FrameCodec.h"
+#include "LzCodec.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond, what) \
+    do { \
+        if (!(cond)) { \
+            ++failures; \
+            std::cerr << "FALHOU: " << (what) << " (" << __FILE__ << ":" << __LINE__ << ")" << std::endl; \
+        } \
+    } while (0)
+
+static std::string randomBytes(std::mt19937& rng, size_t n) {
+    std::string s(n, '\0');
+    for (auto& c : s) c = static_cast<char>(rng() & 0xFF);
+    return s;
+}
+
+static void checkRoundTrip(const std::string& input, const std::string& name) {
+    std::string packed = LzCodec::compress(input);
+    std::string out;
+    CHECK(LzCodec::decompress(packed, input.size(), out), name + ": descompressão");
+    CHECK(out == input, name + ": conteúdo restaurado");
+}
+
+static void testRoundTrips() {
+    std::mt19937 rng(12345);
+    checkRoundTrip("", "vazio");
+    checkRoundTrip("a", "1 byte");
+    checkRoundTrip("abc", "3 bytes");
+    checkRoundTrip("abcd", "4 bytes");
+    checkRoundTrip(std::string(1 << 20, 'a'), "sequência longa");
+    checkRoundTrip(randomBytes(rng, 100000), "incompressível");
+
+    std::string chat;
+    for (int i = 0; i < 2000; ++i) chat += "Cliente_" + std::to_string(i % 7) + ": mensagem " + std::to_string(i) + "\n";
+    checkRoundTrip(chat, "linhas de chat");
+    CHECK(LzCodec::compress(chat).size() < chat.size() / 3, "linhas de chat comprimem");
+
+    // Repetições a mais de 64 KiB de distância não cabem no offset de 2 bytes
+    std::string block = randomBytes(rng, 70 * 1024);
+    checkRoundTrip(block + block, "repetição além de 64 KiB");
+    for (size_t distance : {65534, 65535, 65536, 65537}) {
+        std::string head = randomBytes(rng, 64);
+        std::string filler = randomBytes(rng, distance - head.size());
+        checkRoundTrip(head + filler + head, "repetição a " + std::to_string(distance) + " bytes");
+    }
+}
+
+static void testCorruption() {
+    std::mt19937 rng(777);
+    std::string input;
+    for (int i = 0; i < 300; ++i) input += "linha repetida " + std::to_string(i % 10) + "\n";
+    std::string packed = LzCodec::compress(input);
+    std::string out;
+
+    // Entrada truncada é recusada; só a sequência final vazia (token 0) pode faltar
+    // sem perda, e aí o conteúdo tem de sair idêntico
+    size_t accepted = 0;
+    for (size_t len = 0; len < packed.size(); ++len) {
+        if (LzCodec::decompress(packed.substr(0, len), input.size(), out)) {
+            ++accepted;
+            CHECK(out == input && len + 1 == packed.size() && packed.back() == '\0',
+                  "entrada truncada aceita com " + std::to_string(len) + " bytes");
+        }
+    }
+    CHECK(accepted <= 1, "entrada truncada recusada");
+
+    CHECK(!LzCodec::decompress(packed, input.size() + 1, out), "raw_len maior recusado");
+    CHECK(!LzCodec::decompress(packed, input.size() - 1, out), "raw_len menor recusado");
+
+    // Match sem literais antes: offset 0 e offset além do início
+    CHECK(!LzCodec::decompress(std::string("\x00\x00\x00", 3), 4, out), "offset 0 recusado");
+    CHECK(!LzCodec::decompress(std::string("\x00\x05\x00", 3), 4, out), "offset antes do início recusado");
+    CHECK(!LzCodec::decompress(std::string("\xF0", 1), 100, out), "comprimento de literais truncado recusado");
+
+    // Bytes trocados ao acaso: nunca pode passar de raw_len nem travar
+    for (int trial = 0; trial < 2000; ++trial) {
+        std::string broken = packed;
+        int flips = 1 + static_cast<int>(rng() % 4);
+        for (int f = 0; f < flips; ++f) {
+            broken[rng() % broken.size()] = static_cast<char>(rng() & 0xFF);
+        }
+        if (LzCodec::decompress(broken, input.size(), out)) {
+            CHECK(out.size() == input.size(), "entrada corrompida aceita com tamanho errado");
+        }
+    }
+}
+
+static std::vector<std::string> feedAll(const std::string& stream, size_t step, bool* ok) {
+    FrameCodec decoder;
+    std::vector<std::string> lines;
+    *ok = true;
+    for (size_t pos = 0; pos < stream.size() && *ok; pos += step) {
+        size_t n = std::min(step, stream.size() - pos);
+        *ok = decoder.feed(stream.data() + pos, n, [&](const std::string& line) { lines.push_back(line); });
+    }
+    return lines;
+}
+
+static void testFrames() {
+    std::vector<std::string> history;
+    for (int i = 0; i < 100; ++i) history.push_back("[Cliente_" + std::to_string(i % 5) + "]: mensagem " + std::to_string(i));
+
+    for (bool compress : {false, true}) {
+        std::string name = compress ? "quadro comprimido" : "quadro em texto";
+        std::string frame = FrameCodec::encodeBatch(history, compress);
+        if (compress) {
+            CHECK(frame.compare(0, 9, "@batch 1 ") == 0, name + ": flag LZ");
+        }
+
+        // Linhas soltas antes e depois do quadro, entregues um byte por vez
+        std::string stream = "antes\n" + frame + "depois\n";
+        std::vector<std::string> expected;
+        expected.push_back("antes");
+        expected.insert(expected.end(), history.begin(), history.end());
+        expected.push_back("depois");
+        for (size_t step : {1, 7, 4096}) {
+            bool ok = false;
+            std::vector<std::string> lines = feedAll(stream, step, &ok);
+            CHECK(ok, name + ": fluxo aceito (passo " + std::to_string(step) + ")");
+            CHECK(lines == expected, name + ": linhas entregues (passo " + std::to_string(step) + ")");
+        }
+    }
+
+    bool ok = true;
+    feedAll("@batch 1 100 5\nxxxxx", 1, &ok);
+    CHECK(!ok, "payload comprimido inválido recusado");
+    feedAll("@batch 0 1 99999999999\n", 1, &ok);
+    CHECK(!ok, "tamanho de lote acima do limite recusado");
+    feedAll("@batch x y z\n", 1, &ok);
+    CHECK(!ok, "cabeçalho malformado recusado");
+
+    // Quadro sem linhas
+    std::string empty_frame = FrameCodec::encodeBatch(std::vector<std::string>(), true);
+    std::vector<std::string> lines = feedAll(empty_frame + "fim\n", 1, &ok);
+    CHECK(ok && lines == std::vector<std::string>{"fim"}, "quadro vazio");
+}
+
+int main() {
+    testRoundTrips();
+    testCorruption();
+    testFrames();
+    if (failures > 0) {
+        std::cerr << failures << " verificação(ões) falharam." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "codec_test: tudo certo." << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -1,25 +1,120 @@
-#include "ChatClient.h"
+#include "AsyncChatClient.h"
+#include "PresenceTracker.h"
+#include <atomic>
 #include <iostream>
+#include <vector>
 
-int main() {
+// Mensagens do histórico mostradas ao conectar
+#define HISTORY_ON_CONNECT 20
+
+// Uso: chat_client [host] [porta] [conexões]
+//   host pode ser "unix:/caminho" para o socket local do servidor.
+// Cada linha do stdin é enviada por todas as conexões; só as mensagens da
+// primeira conexão são impressas (as outras receberiam as mesmas). As linhas de
+// presença viram avisos de entrada/saída; /who lista quem está no chat. Ao
+// conectar, as últimas mensagens do histórico são mostradas.
+int main(int argc, char* argv[]) {
     try {
-        ChatClient client;
-        // Cliente CLI: conectar 
-        client.connectToServer("127.0.0.1", 8080); 
-        
-        std::cout << "Conectado. Digite mensagens (ou /quit para sair):" << std::endl;
-        
+        std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+        int port = argc > 2 ? std::stoi(argv[2]) : 8080;
+        size_t connections = argc > 3 ? std::stoul(argv[3]) : 1;
+        if (connections == 0) connections = 1;
+
+        AsyncChatClient client;
+        std::string output;
+        size_t received = 0;
+        PresenceTracker presence;
+        std::atomic<bool> who_requested{false};
+        AsyncChatClient::ConnectionId printed = 0; // a primeira conexão; definida antes do start()
+
+        // Os callbacks rodam todos na thread do loop: o buffer de saída é esvaziado
+        // uma vez por rodada, em vez de um flush por mensagem
+        client.setMessageHandler([&](AsyncChatClient::ConnectionId id, const std::string& line) {
+            ++received;
+            if (id != printed) return;
+
+            std::vector<PresenceTracker::Change> changes;
+            switch (presence.handleLine(line, &changes)) {
+            case PresenceTracker::Result::NOT_PRESENCE:
+                if (line.compare(0, 5, "@caps") == 0) break; // resposta da negociação
+                output += line;
+                output += '\n';
+                break;
+            case PresenceTracker::Result::RESYNC:
+                client.send(id, "/roster");
+                break;
+            case PresenceTracker::Result::APPLIED:
+                // /who pede um snapshot novo; a lista é impressa quando ele chega
+                if (line.compare(0, 7, "@roster") == 0 && who_requested.exchange(false)) {
+                    output += "*** " + std::to_string(presence.getMembers().size()) + " no chat:";
+                    for (const auto& m : presence.getMembers()) output += " " + m.second;
+                    output += '\n';
+                }
+                for (const auto& c : changes) {
+                    if (c.kind == PresenceTracker::Change::JOINED) {
+                        output += "*** " + c.name + " entrou no chat\n";
+                    } else if (c.kind == PresenceTracker::Change::LEFT) {
+                        output += "*** " + c.name + " saiu do chat\n";
+                    } else {
+                        output += "*** " + c.old_name + " agora é " + c.name + "\n";
+                    }
+                }
+                break;
+            case PresenceTracker::Result::STALE:
+                break;
+            }
+        });
+        client.setIdleHandler([&] {
+            if (!output.empty()) {
+                std::cout << output << std::flush;
+                output.clear();
+            }
+        });
+
+        // Ao (re)conectar, as últimas mensagens chegam num lote comprimido
+        client.setHistoryOnConnect(HISTORY_ON_CONNECT);
+
+        // Cliente CLI: conectar
+        std::vector<AsyncChatClient::ConnectionId> ids;
+        for (size_t i = 0; i < connections; ++i) {
+            ids.push_back(client.addConnection(host, port));
+        }
+        printed = ids[0];
+        client.start();
+
+        std::cout << "Conectando " << connections << " conexão(ões) a " << host
+                  << (host.compare(0, 5, "unix:") == 0 ? "" : ":" + std::to_string(port))
+                  << ". Digite mensagens (ou /quit para sair):" << std::endl;
+
         std::string message;
         while (std::getline(std::cin, message)) {
             if (message == "/quit") {
                 break;
             }
-            // Cliente CLI: enviar mensagens 
-            client.sendMessage(message); 
+            if (message.empty()) continue;
+            if (message == "/who") {
+                who_requested = true;
+                client.send(ids[0], "/roster");
+                continue;
+            }
+            // Cliente CLI: enviar mensagens (enfileiradas; o loop agrupa os envios)
+            for (auto id : ids) {
+                client.send(id, message);
+            }
+        }
+
+        if (!client.drain(std::chrono::seconds(5))) {
+            std::cerr << "Aviso: mensagens pendentes não enviadas." << std::endl;
+        }
+        client.stop();
+        std::cout << output << std::flush;
+
+        if (connections > 1) {
+            std::cerr << received << " mensagens recebidas em " << connections << " conexões." << std::endl;
         }
     } catch (const std::exception& e) {
         std::cerr << "Erro fatal no cliente: " << e.what() << std::endl;
         return 1;
     }
     return 0;
-}  
\ No newline at end of file
+}
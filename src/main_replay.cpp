@@ -0,0 +1,172 @@
+#include "AsyncChatClient.h"
+#include "TrafficCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Reproduz uma captura (chat_server --capture) contra um servidor e mede
+// vazão e latência. A latência é medida por uma conexão observadora extra, que
+// recebe todos os broadcasts: do envio da mensagem até ela chegar no observador.
+//
+// Uso: chat_replay ARQUIVO [host] [porta] [--fast | --speed X]
+
+using Clock = std::chrono::steady_clock;
+
+static void printUsage(const char* prog) {
+    std::cerr << "Uso: " << prog << " ARQUIVO [host] [porta] [--fast | --speed X]\n"
+              << "  --fast     envia o mais rápido possível (ignora os tempos gravados)\n"
+              << "  --speed X  acelera (X > 1) ou desacelera o tempo original\n";
+}
+
+static double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[idx];
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> positional;
+    bool fast = false;
+    double speed = 1.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fast") {
+            fast = true;
+        } else if (arg == "--speed" && i + 1 < argc) {
+            speed = std::stod(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.empty() || speed <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::string host = positional.size() > 1 ? positional[1] : "127.0.0.1";
+        int port = positional.size() > 2 ? std::stoi(positional[2]) : 8080;
+        std::vector<CaptureRecord> records = TrafficCapture::readAll(positional[0]);
+        std::cout << records.size() << " eventos carregados de " << positional[0] << std::endl;
+
+        AsyncChatClient client;
+
+        // Envios aguardando o eco no observador, por conteúdo
+        std::mutex pending_mutex;
+        std::unordered_multimap<std::string, Clock::time_point> pending;
+        std::vector<double> latencies_ms;
+        Clock::time_point last_echo;
+
+        AsyncChatClient::ConnectionId observer = 0;
+        client.setMessageHandler([&](AsyncChatClient::ConnectionId id, const std::string& line) {
+            if (id != observer) return;
+            // "remetente: texto"
+            size_t sep = line.find(": ");
+            if (sep == std::string::npos) return;
+            std::string text = line.substr(sep + 2);
+            auto now = Clock::now();
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            auto it = pending.find(text);
+            if (it == pending.end()) return;
+            latencies_ms.push_back(std::chrono::duration<double, std::milli>(now - it->second).count());
+            pending.erase(it);
+            last_echo = now;
+        });
+
+        observer = client.addConnection(host, port);
+        client.start();
+
+        // Dá tempo ao observador de entrar antes do tráfego
+        for (int i = 0; i < 100 && client.getConnectedCount() == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        std::map<uint64_t, AsyncChatClient::ConnectionId> connections;
+        size_t sent = 0;
+        size_t commands = 0;
+        auto start = Clock::now();
+
+        for (const auto& r : records) {
+            if (!fast) {
+                auto due = start + std::chrono::microseconds(static_cast<uint64_t>(r.timestamp_us / speed));
+                std::this_thread::sleep_until(due);
+            }
+
+            if (r.type == CaptureEvent::JOIN) {
+                connections[r.connection] = client.addConnection(host, port);
+            } else if (r.type == CaptureEvent::LEAVE) {
+                auto it = connections.find(r.connection);
+                if (it != connections.end()) {
+                    client.closeConnection(it->second);
+                    connections.erase(it);
+                }
+            } else {
+                // Conexão já ativa antes do início da captura: cria sob demanda
+                auto it = connections.find(r.connection);
+                if (it == connections.end()) {
+                    it = connections.emplace(r.connection, client.addConnection(host, port)).first;
+                }
+                // Comandos (/history, /nick, ...) vão como foram gravados, mas não
+                // geram broadcast: só o chat entra na medida de latência
+                if (r.payload.compare(0, 1, "/") == 0) {
+                    client.send(it->second, r.payload);
+                    ++commands;
+                    continue;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(pending_mutex);
+                    pending.emplace(r.payload, Clock::now());
+                }
+                client.send(it->second, r.payload);
+                ++sent;
+            }
+        }
+
+        client.drain(std::chrono::seconds(10));
+        auto send_done = Clock::now();
+
+        // Espera os ecos restantes (até 2 s sem novidade)
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            if (pending.empty() || Clock::now() - std::max(last_echo, send_done) > std::chrono::seconds(2)) break;
+        }
+        client.stop();
+
+        std::vector<double> lat;
+        Clock::time_point done;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            lat = latencies_ms;
+            done = std::max(last_echo, send_done);
+        }
+        std::sort(lat.begin(), lat.end());
+
+        // Vazão até o último eco: no modo --fast o envio em si termina quase instantaneamente
+        double sending = std::chrono::duration<double>(send_done - start).count();
+        double elapsed = std::chrono::duration<double>(done - start).count();
+        std::cout << "Mensagens enviadas: " << sent << " + " << commands << " comandos (escritos em "
+                  << sending << " s)" << std::endl;
+        std::cout << "Entregues ao observador: " << lat.size() << "/" << sent << " em " << elapsed << " s ("
+                  << (elapsed > 0 ? lat.size() / elapsed : 0.0) << " msg/s)" << std::endl;
+        if (!lat.empty()) {
+            std::cout << "Latência (ms): p50=" << percentile(lat, 0.50)
+                      << " p90=" << percentile(lat, 0.90)
+                      << " p99=" << percentile(lat, 0.99)
+                      << " max=" << lat.back() << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Erro fatal no replay: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
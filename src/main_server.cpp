@@ -1,14 +1,112 @@
 #include "ChatServer.h"
 #include <iostream>
+#include <cstring>
 
-int main() {
+static void printUsage(const char* prog) {
+    std::cerr << "Uso: " << prog << " [porta] [opções]\n"
+              << "  --unix CAMINHO      também escuta clientes locais num socket AF_UNIX\n"
+              << "  --capture ARQUIVO   grava o tráfego de entrada (para o chat_replay)\n"
+              << "  --max-backlog BYTES chat enfileirado por cliente antes de descartar (padrão 4 MiB)\n"
+              << "  --sndbuf BYTES      SO_SNDBUF por cliente (padrão 64 KiB; 0 = kernel)\n"
+              << "  --fanout-workers N  threads de fanout (padrão = núcleos, 0 com um núcleo; 0 = sempre inline)\n"
+              << "  --fanout-threshold N destinatários mínimos para o fanout paralelo (padrão 2048)\n"
+              << "  --fanout-chunk N    destinatários por tarefa de fanout (padrão 512)\n"
+              << "  --presence-window MS  agrega entradas/saídas por MS ms (padrão 50)\n"
+              << "  --max-connections N recusa conexões acima de N clientes (0 = sem limite)\n"
+              << "  --max-memory BYTES  recusa conexões e descarta chat acima desta memória estimada\n"
+              << "  --log ARQUIVO       arquivo de log (padrão chat_server.log)\n"
+              << "  --log-format F      text ou binary (binário: ler com tslog_decode)\n"
+              << "  --log-level N       debug, info, warn ou error (padrão debug)\n"
+              << "  --log-max-bytes N   rotaciona o log ao passar de N bytes (0 = nunca)\n"
+              << "  --log-max-age S     rotaciona o log a cada S segundos (0 = nunca)\n"
+              << "  --log-keep N        arquivos de log antigos mantidos (padrão 5)\n"
+              << "  --quiet             não repete o log no console\n"
+              << "  --node-id ID        identificador deste nó na federação\n"
+              << "  --peer-port P       escuta outros nós na porta P\n"
+              << "  --peer-bind ADDR    endereço da porta de pares (padrão 127.0.0.1; os pares não\n"
+              << "                      são autenticados, só abra em rede confiável)\n"
+              << "  --peer HOST:PORTA   conecta à porta de pares de outro nó (repetível; cada nó\n"
+              << "                      precisa de link com todos os outros: não há retransmissão;\n"
+              << "                      a lista de presença /roster continua sendo só deste nó)\n";
+}
+
+int main(int argc, char* argv[]) {
     try {
-        const int port = 8080;
-        ChatServer server(port);
+        ServerOptions options;
+        LoggerConfig log_config;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--unix" && has_value) {
+                options.unix_path = argv[++i];
+            } else if (arg == "--capture" && has_value) {
+                options.capture_path = argv[++i];
+            } else if (arg == "--max-backlog" && has_value) {
+                options.max_backlog_bytes = std::stoul(argv[++i]);
+            } else if (arg == "--sndbuf" && has_value) {
+                options.socket_send_buffer = std::stoi(argv[++i]);
+            } else if (arg == "--fanout-workers" && has_value) {
+                options.fanout_workers = std::stoul(argv[++i]);
+            } else if (arg == "--fanout-threshold" && has_value) {
+                options.fanout_threshold = std::stoul(argv[++i]);
+            } else if (arg == "--fanout-chunk" && has_value) {
+                options.fanout_chunk_size = std::stoul(argv[++i]);
+            } else if (arg == "--presence-window" && has_value) {
+                options.presence_window_ms = std::stoi(argv[++i]);
+            } else if (arg == "--max-connections" && has_value) {
+                options.max_connections = std::stoul(argv[++i]);
+            } else if (arg == "--max-memory" && has_value) {
+                options.max_memory_bytes = std::stoul(argv[++i]);
+            } else if (arg == "--log" && has_value) {
+                log_config.filename = argv[++i];
+            } else if (arg == "--log-format" && has_value) {
+                std::string format = argv[++i];
+                if (format != "text" && format != "binary") {
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                log_config.format = format == "binary" ? LogFormat::BINARY : LogFormat::TEXT;
+            } else if (arg == "--log-level" && has_value) {
+                std::string level = argv[++i];
+                if (level == "debug") log_config.min_level = DEBUG;
+                else if (level == "info") log_config.min_level = INFO;
+                else if (level == "warn") log_config.min_level = WARNING;
+                else if (level == "error") log_config.min_level = ERROR;
+                else {
+                    printUsage(argv[0]);
+                    return 1;
+                }
+            } else if (arg == "--log-max-bytes" && has_value) {
+                log_config.max_file_bytes = std::stoul(argv[++i]);
+            } else if (arg == "--log-max-age" && has_value) {
+                log_config.max_file_age_s = std::stoi(argv[++i]);
+            } else if (arg == "--log-keep" && has_value) {
+                log_config.retention = std::stoi(argv[++i]);
+            } else if (arg == "--quiet") {
+                log_config.console = false;
+            } else if (arg == "--node-id" && has_value) {
+                options.node_id = argv[++i];
+            } else if (arg == "--peer-port" && has_value) {
+                options.peer_port = std::stoi(argv[++i]);
+            } else if (arg == "--peer-bind" && has_value) {
+                options.peer_bind = argv[++i];
+            } else if (arg == "--peer" && has_value) {
+                options.peers.push_back(argv[++i]);
+            } else if (arg.rfind("--", 0) != 0) {
+                options.port = std::stoi(arg);
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        ThreadSafeLogger::getInstance().configure(log_config);
+
+        ChatServer server(options);
         server.start(); // Bloqueia a thread principal
     } catch (const std::exception& e) {
         std::cerr << "Erro fatal no servidor: " << e.what() << std::endl;
         return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
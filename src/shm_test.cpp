@@ -0,0 +1,116 @@
+// Arquivo: src/shm_test.cpp
+// Teste do transporte em memória compartilhada: sobe um servidor no próprio
+// processo (socket AF_UNIX), envia comandos pelo anel e confere que eles são
+// executados e não retransmitidos como chat.
+// Sai com status 1 se alguma verificação falhar.
+
+#include "ChatServer.h"
+#include "ChatClient.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond, what) \
+    do { \
+        if (!(cond)) { \
+            ++failures; \
+            std::cerr << "FALHOU: " << (what) << " (" << __FILE__ << ":" << __LINE__ << ")" << std::endl; \
+        } \
+    } while (0)
+
+// Linhas recebidas por um cliente, com espera por uma linha específica
+struct Inbox {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> lines;
+
+    void push(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        lines.push_back(line);
+        cv.notify_all();
+    }
+
+    bool waitFor(const std::string& needle) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] {
+            for (const auto& l : lines) {
+                if (l.find(needle) != std::string::npos) return true;
+            }
+            return false;
+        });
+    }
+
+    bool contains(const std::string& needle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& l : lines) {
+            if (l.find(needle) != std::string::npos) return true;
+        }
+        return false;
+    }
+};
+
+int main() {
+    ServerOptions options;
+    options.port = 0; // o teste usa só o socket local
+    options.unix_path = "/tmp/chat_shm_test_" + std::to_string(getpid()) + ".sock";
+
+    // start() não retorna: o servidor fica numa thread e é encerrado com o processo
+    auto* server = new ChatServer(options);
+    std::thread([server] { server->start(); }).detach();
+
+    Inbox sender_inbox, observer_inbox;
+    ChatClient sender, observer;
+    sender.setMessageHandler([&](const std::string& line) { sender_inbox.push(line); });
+    observer.setMessageHandler([&](const std::string& line) { observer_inbox.push(line); });
+
+    bool connected = false;
+    for (int attempt = 0; attempt < 50 && !connected; ++attempt) {
+        try {
+            observer.connectToUnix(options.unix_path);
+            connected = true;
+        } catch (const std::exception&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    CHECK(connected, "conexão do observador");
+    if (!connected) return EXIT_FAILURE;
+    sender.connectToUnix(options.unix_path);
+    CHECK(sender.enableSharedMemory(), "anel aceito pelo servidor");
+
+    sender.sendMessage("/nick anel");
+    sender.sendMessage("/ping");
+    sender.sendMessage("");
+    sender.sendMessage("ola pelo anel");
+    sender.sendMessage("primeira\nsegunda");
+    // O pedido de histórico segue pelo anel, atrás do chat acima
+    sender.requestHistory(10, true);
+
+    CHECK(observer_inbox.waitFor("anel: segunda"), "chat pelo anel entregue com o novo nome");
+    CHECK(observer_inbox.contains("anel: ola pelo anel"), "/nick pelo anel executado");
+    CHECK(observer_inbox.contains("anel: primeira"), "linhas de uma mensagem do anel separadas");
+    CHECK(sender_inbox.waitFor("PONG"), "/ping pelo anel respondido");
+    CHECK(sender_inbox.waitFor("segunda"), "/history pelo anel vê o chat enviado antes");
+    CHECK(!observer_inbox.contains("/nick") && !observer_inbox.contains("/ping") &&
+          !observer_inbox.contains("/history") && !observer_inbox.contains("/caps"),
+          "comandos pelo anel não retransmitidos");
+
+    sender.disconnect();
+    observer.disconnect();
+    unlink(options.unix_path.c_str());
+
+    if (failures > 0) {
+        std::cerr << failures << " verificação(ões) falharam." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "shm_test: tudo certo." << std::endl;
+    return EXIT_SUCCESS;
+}